@@ -9,12 +9,50 @@
  * file:        TPS65185.hpp
  */
 
+#ifndef TPS65185_HPP
+#define TPS65185_HPP
+
 #include <cinttypes>
 
+/* Position of the lowest set bit of a field mask, evaluated at compile time */
+template <uint16_t mask>
+struct TPS65185_Shift
+{
+	static const uint8_t value = (mask & 1) ? 0 : 1 + TPS65185_Shift<(mask >> 1)>::value;
+};
+
+template <>
+struct TPS65185_Shift<0>
+{
+	static const uint8_t value = 0;
+};
+
+/* Register word type by width in bytes */
+template <int bytes> struct TPS65185_Word;
+template <> struct TPS65185_Word<1> { typedef uint8_t type; };
+template <> struct TPS65185_Word<2> { typedef uint16_t type; };
+
+/* Properties of a bit field struct F such as TPS65185_Base::ENABLE::VCOM_EN */
+template <class F>
+struct TPS65185_Field
+{
+	typedef typename TPS65185_Word<sizeof(F::mask)>::type type;
+	static const uint16_t address = F::__address;
+	static const uint8_t shift = TPS65185_Shift<F::mask>::value;
+};
+
 /* Derive from class TPS65185_Base and implement the read and write functions! */
 
-/* TPS65185: Single chip PMIC for E Ink (R) Vizplex (TM) Enabled Electronic Paper Display */
-class TPS65185_Base
+/*
+ * Transport of TPS65185_Base: register access through virtual functions.
+ * For statically dispatched, inlinable register access instantiate TPS65185_Device<Transport>
+ * directly with a class that provides the same six functions as plain (non-virtual)
+ * members; readBurst() and writeBurst() may simply loop over read8() and write().
+ * writeBurst() is only needed by users of cachedWriteBurst() such as TPS65185_Batch.
+ * A transport whose transfers can fail reports it with transferFailed(), so failed reads
+ * never enter the shadow cache; TPS65185_NoBase supplies the default for the others.
+ */
+class TPS65185_Transport
 {
 public:
 	/* Pure virtual functions that need to be implemented in derived class: */
@@ -23,6 +61,303 @@ public:
 	virtual uint16_t read16(uint16_t address, uint16_t n=16) = 0;  // 16 bit read
 	virtual void write(uint16_t address, uint16_t value, uint16_t n=16) = 0;  // 16 bit write
 	
+	/* Virtual functions with a default implementation, override for faster transports: */
+	virtual void readBurst(uint16_t address, uint8_t *data, uint16_t count)  // auto-increment read
+	{
+		for (uint16_t i = 0; i < count; i++)
+			data[i] = read8(address + i, 8);
+	}
+	
+	virtual void writeBurst(uint16_t address, const uint8_t *data, uint16_t count)  // auto-increment write
+	{
+		for (uint16_t i = 0; i < count; i++)
+			write(address + i, data[i], 8);
+	}
+	
+	/* Did the last transfer fail? */
+	virtual bool transferFailed() const
+	{
+		return false;
+	}
+	
+	virtual ~TPS65185_Transport() {}
+};
+
+/* Base for transports such as TPS65185_Sim<> used with static dispatch */
+class TPS65185_NoBase
+{
+public:
+	/* Transfers never fail unless the transport says otherwise */
+	bool transferFailed() const
+	{
+		return false;
+	}
+};
+
+/* TPS65185: Single chip PMIC for E Ink (R) Vizplex (TM) Enabled Electronic Paper Display */
+template <class Transport>
+class TPS65185_Device : public Transport
+{
+public:
+	TPS65185_Device() : cache_enabled(false), cache_valid(0) {}
+	
+	explicit TPS65185_Device(const Transport &transport) : Transport(transport), cache_enabled(false), cache_valid(0) {}
+	
+	
+	/*****************************************************************************************************\
+	 *                                                                                                   *
+	 *                                           SHADOW CACHE                                            *
+	 *                                                                                                   *
+	\*****************************************************************************************************/
+	
+	/*
+	 * Optional write-through shadow of the register file (addresses 0..16).
+	 * When enabled, getXXX() of a configuration register is served from the shadow once
+	 * the register has been read or written, and setXXX() updates the shadow after the
+	 * bus write; a read the transport reports as failed is not shadowed. Volatile bits are
+	 * never served from the shadow:
+	 * - TMST_VALUE, INT1, INT2 and PG always go to the bus
+	 * - ENABLE::ACTIVE/STANDBY, VCOM::ACQ/PROG and TMST1::READ_THERM/CONV_END read
+	 *   as 0 from the shadow; use read8()/read16() directly for their live value
+	 * Writing a self-clearing bit hands the register over to the device, so its shadow
+	 * entry is dropped and refreshed on the next read; VCOM::ACQ and VCOM::PROG drop both
+	 * VCOM bytes, as the device rewrites VCOM[7:0] too. Writes to the read-only REVID are
+	 * not shadowed.
+	 */
+	static const uint16_t __registers = 17;
+	
+	/* Enable or disable the shadow cache; both drop all shadowed values */
+	void setCacheEnabled(bool enabled)
+	{
+		cache_enabled = enabled;
+		cache_valid = 0;
+	}
+	
+	/* Is the shadow cache enabled? */
+	bool isCacheEnabled() const
+	{
+		return cache_enabled;
+	}
+	
+	/* Drop all shadowed values, e.g. after a device reset */
+	void invalidateCache()
+	{
+		cache_valid = 0;
+	}
+	
+	/* Drop the shadowed value of a single register address */
+	void invalidateCache(uint16_t address)
+	{
+		if (address < __registers)
+			cache_valid &= ~(1UL << address);
+	}
+	
+	/* Bits of register address that change without being written by the host */
+	static uint8_t volatileMask(uint16_t address)
+	{
+		switch (address)
+		{
+			case TMST_VALUE::__address: return 0xff;
+			case ENABLE::__address:     return ENABLE::ACTIVE::mask | ENABLE::STANDBY::mask;
+			case VCOM::__address + 1:   return (VCOM::ACQ::mask | VCOM::PROG::mask) >> 8;
+			case INT1::__address:       return 0xff;
+			case INT2::__address:       return 0xff;
+			case TMST1::__address:      return TMST1::READ_THERM::mask | TMST1::CONV_END::mask;
+			case PG::__address:         return 0xff;
+			default:                    return 0x00;
+		}
+	}
+	
+	/* Can register address be served from the shadow at all? */
+	static bool isCacheable(uint16_t address)
+	{
+		return address < __registers && volatileMask(address) != 0xff;
+	}
+	
+	/* 8 bit read through the shadow cache */
+	uint8_t cachedRead8(uint16_t address, uint16_t n=8)
+	{
+		if (!cache_enabled || !isCacheable(address))
+			return this->read8(address, n);
+		if (!isCached(address))
+		{
+			uint8_t value = this->read8(address, n);
+			if (this->transferFailed())
+				return value;
+			store(address, value);
+		}
+		return shadow[address] & ~volatileMask(address);
+	}
+	
+	/* 8 bit write through the shadow cache */
+	void cachedWrite(uint16_t address, uint8_t value, uint16_t n=8)
+	{
+		this->write(address, value, n);
+		if (cache_enabled)
+			update(address, value);
+	}
+	
+	/* 16 bit read through the shadow cache, byteorder little */
+	uint16_t cachedRead16(uint16_t address, uint16_t n=16)
+	{
+		if (!cache_enabled || !isCacheable(address) || !isCacheable(address + 1))
+			return this->read16(address, n);
+		if (!isCached(address) || !isCached(address + 1))
+		{
+			uint16_t value = this->read16(address, n);
+			if (this->transferFailed())
+				return value;
+			store(address, value & 0xff);
+			store(address + 1, value >> 8);
+		}
+		return (shadow[address] & ~volatileMask(address))
+			| (uint16_t(shadow[address + 1] & ~volatileMask(address + 1)) << 8);
+	}
+	
+	/* 16 bit write through the shadow cache, byteorder little */
+	void cachedWrite(uint16_t address, uint16_t value, uint16_t n=16)
+	{
+		this->write(address, value, n);
+		if (cache_enabled)
+		{
+			update(address, value & 0xff);
+			update(address + 1, value >> 8);
+		}
+	}
+	
+	/* Auto-increment write of count registers through the shadow cache */
+	void cachedWriteBurst(uint16_t address, const uint8_t *data, uint16_t count)
+	{
+		this->writeBurst(address, data, count);
+		if (cache_enabled)
+		{
+			for (uint16_t i = 0; i < count; i++)
+				update(address + i, data[i]);
+		}
+	}
+	
+	
+	/*****************************************************************************************************\
+	 *                                                                                                   *
+	 *                                           FIELD ACCESS                                            *
+	 *                                                                                                   *
+	\*****************************************************************************************************/
+	
+	/*
+	 * Read-modify-write access to a single bit field, e.g. set<ENABLE::VCOM_EN>(1) or
+	 * get<UPSEQ1::UDLY2>(). Values are right-aligned. Both go through the shadow cache,
+	 * so with the cache enabled set() costs a single bus write. Self-clearing bits of
+	 * the register are written as 0 (no effect) by set(). get() of a field with
+	 * self-clearing bits, e.g. get<TMST1::CONV_END>(), always reads the bus.
+	 */
+	template <class F>
+	typename TPS65185_Field<F>::type get()
+	{
+		return extract<F>(getRegister<F>());
+	}
+	
+	/* Returns the register value written */
+	template <class F>
+	typename TPS65185_Field<F>::type set(typename TPS65185_Field<F>::type value)
+	{
+		typedef typename TPS65185_Field<F>::type type;
+		type reg = cachedRead(F::__address, (type *)0) & ~volatileBits(F::__address, (type *)0);
+		reg = insert<F>(reg, value);
+		cachedWrite(F::__address, reg, sizeof(type) * 8);
+		return reg;
+	}
+	
+	/* Register holding field F, read as get<F>() reads it */
+	template <class F>
+	typename TPS65185_Field<F>::type getRegister()
+	{
+		typedef typename TPS65185_Field<F>::type type;
+		if (F::mask & volatileBits(F::__address, (type *)0))
+			return uncachedRead(F::__address, (type *)0);
+		return cachedRead(F::__address, (type *)0);
+	}
+	
+	/* Extract bit field F from a register value */
+	template <class F>
+	static typename TPS65185_Field<F>::type extract(typename TPS65185_Field<F>::type reg)
+	{
+		return (reg & F::mask) >> TPS65185_Field<F>::shift;
+	}
+	
+	/* Replace bit field F in a register value */
+	template <class F>
+	static typename TPS65185_Field<F>::type insert(typename TPS65185_Field<F>::type reg,
+		typename TPS65185_Field<F>::type value)
+	{
+		return (reg & ~F::mask) | ((value << TPS65185_Field<F>::shift) & F::mask);
+	}
+	
+	
+	/*****************************************************************************************************\
+	 *                                                                                                   *
+	 *                                             SNAPSHOT                                              *
+	 *                                                                                                   *
+	\*****************************************************************************************************/
+	
+	/*
+	 * All registers (addresses 0..16) decoded from a single burst read.
+	 * NOTE: Reading INT1 and INT2 clears pending interrupts.
+	 */
+	struct Snapshot
+	{
+		uint8_t tmst_value;
+		uint8_t enable;
+		uint8_t vadj;
+		uint16_t vcom;
+		uint8_t int_en1;
+		uint8_t int_en2;
+		uint8_t int1;
+		uint8_t int2;
+		uint8_t upseq0;
+		uint8_t upseq1;
+		uint8_t dwnseq0;
+		uint8_t dwnseq1;
+		uint8_t tmst1;
+		uint8_t tmst2;
+		uint8_t pg;
+		uint8_t revid;
+		
+		/* Decode __registers bytes read from address 0 */
+		void decode(const uint8_t *data)
+		{
+			tmst_value = data[TMST_VALUE::__address];
+			enable = data[ENABLE::__address];
+			vadj = data[VADJ::__address];
+			vcom = data[VCOM::__address] | (uint16_t(data[VCOM::__address + 1]) << 8);
+			int_en1 = data[INT_EN1::__address];
+			int_en2 = data[INT_EN2::__address];
+			int1 = data[INT1::__address];
+			int2 = data[INT2::__address];
+			upseq0 = data[UPSEQ0::__address];
+			upseq1 = data[UPSEQ1::__address];
+			dwnseq0 = data[DWNSEQ0::__address];
+			dwnseq1 = data[DWNSEQ1::__address];
+			tmst1 = data[TMST1::__address];
+			tmst2 = data[TMST2::__address];
+			pg = data[PG::__address];
+			revid = data[REVID::__address];
+		}
+	};
+	
+	/* Read all registers in one burst; refreshes the shadow cache when enabled */
+	void readSnapshot(Snapshot &snapshot)
+	{
+		uint8_t data[__registers];
+		this->readBurst(0, data, __registers);
+		snapshot.decode(data);
+		if (cache_enabled && !this->transferFailed())
+		{
+			for (uint16_t address = 0; address < __registers; address++)
+				if (isCacheable(address))
+					store(address, data[address]);
+		}
+	}
+	
 	
 	/*****************************************************************************************************\
 	 *                                                                                                   *
@@ -55,6 +390,7 @@ public:
 		/* Bits TEMP: */
 		struct TEMP
 		{
+			static const uint16_t __address = 0;
 			static const uint8_t mask = 0b11111111; // [0,1,2,3,4,5,6,7]
 		};
 	};
@@ -62,13 +398,13 @@ public:
 	/* Set register TMST_VALUE */
 	void setTMST_VALUE(uint8_t value)
 	{
-		write(TMST_VALUE::__address, value, 8);
+		cachedWrite(TMST_VALUE::__address, value, 8);
 	}
 	
 	/* Get register TMST_VALUE */
 	uint8_t getTMST_VALUE()
 	{
-		return read8(TMST_VALUE::__address, 8);
+		return cachedRead8(TMST_VALUE::__address, 8);
 	}
 	
 	
@@ -95,6 +431,7 @@ public:
 		 */
 		struct ACTIVE
 		{
+			static const uint16_t __address = 1;
 			static const uint8_t dflt = 0b0; // 1'b0
 			static const uint8_t mask = 0b10000000; // [7]
 		};
@@ -107,6 +444,7 @@ public:
 		 */
 		struct STANDBY
 		{
+			static const uint16_t __address = 1;
 			static const uint8_t dflt = 0b0; // 1'b0
 			static const uint8_t mask = 0b01000000; // [6]
 		};
@@ -114,6 +452,7 @@ public:
 		/* VIN3P3 to V3P3 switch enable (1=ON)  */
 		struct V3P3_EN
 		{
+			static const uint16_t __address = 1;
 			static const uint8_t dflt = 0b0; // 1'b0
 			static const uint8_t mask = 0b00100000; // [5]
 		};
@@ -121,6 +460,7 @@ public:
 		/* VCOM buffer enable (1 = enabled)  */
 		struct VCOM_EN
 		{
+			static const uint16_t __address = 1;
 			static const uint8_t dflt = 0b0; // 1'b0
 			static const uint8_t mask = 0b00010000; // [4]
 		};
@@ -128,6 +468,7 @@ public:
 		/* VDDH charge pump enable (1 = enabled)  */
 		struct VDDH_EN
 		{
+			static const uint16_t __address = 1;
 			static const uint8_t dflt = 0b0; // 1'b0
 			static const uint8_t mask = 0b00001000; // [3]
 		};
@@ -138,6 +479,7 @@ public:
 		 */
 		struct VPOS_EN
 		{
+			static const uint16_t __address = 1;
 			static const uint8_t dflt = 0b0; // 1'b0
 			static const uint8_t mask = 0b00000100; // [2]
 		};
@@ -145,6 +487,7 @@ public:
 		/* VEE charge pump enable (1 = enabled)  */
 		struct VEE_EN
 		{
+			static const uint16_t __address = 1;
 			static const uint8_t dflt = 0b0; // 1'b0
 			static const uint8_t mask = 0b00000010; // [1]
 		};
@@ -155,6 +498,7 @@ public:
 		 */
 		struct VNEG_EN
 		{
+			static const uint16_t __address = 1;
 			static const uint8_t dflt = 0b0; // 1'b0
 			static const uint8_t mask = 0b00000001; // [0]
 		};
@@ -163,13 +507,13 @@ public:
 	/* Set register ENABLE */
 	void setENABLE(uint8_t value)
 	{
-		write(ENABLE::__address, value, 8);
+		cachedWrite(ENABLE::__address, value, 8);
 	}
 	
 	/* Get register ENABLE */
 	uint8_t getENABLE()
 	{
-		return read8(ENABLE::__address, 8);
+		return cachedRead8(ENABLE::__address, 8);
 	}
 	
 	
@@ -190,6 +534,7 @@ public:
 		/* Bits unused_0: */
 		struct unused_0
 		{
+			static const uint16_t __address = 2;
 			static const uint8_t dflt = 0b00100; // 5'b100
 			static const uint8_t mask = 0b11111000; // [3,4,5,6,7]
 		};
@@ -197,6 +542,7 @@ public:
 		/* VPOS and VNEG voltage setting  */
 		struct VSET
 		{
+			static const uint16_t __address = 2;
 			static const uint8_t dflt = 0b011; // 3'b11
 			static const uint8_t mask = 0b00000111; // [0,1,2]
 			static const uint8_t unused_0 = 0b00; // not valid
@@ -213,13 +559,13 @@ public:
 	/* Set register VADJ */
 	void setVADJ(uint8_t value)
 	{
-		write(VADJ::__address, value, 8);
+		cachedWrite(VADJ::__address, value, 8);
 	}
 	
 	/* Get register VADJ */
 	uint8_t getVADJ()
 	{
-		return read8(VADJ::__address, 8);
+		return cachedRead8(VADJ::__address, 8);
 	}
 	
 	
@@ -246,6 +592,7 @@ public:
 		 */
 		struct ACQ
 		{
+			static const uint16_t __address = 3;
 			static const uint16_t dflt = 0b0; // 1'b0
 			static const uint16_t mask = 0b1000000000000000; // [15]
 		};
@@ -259,6 +606,7 @@ public:
 		 */
 		struct PROG
 		{
+			static const uint16_t __address = 3;
 			static const uint16_t dflt = 0b0; // 1'b0
 			static const uint16_t mask = 0b0100000000000000; // [14]
 		};
@@ -270,6 +618,7 @@ public:
 		 */
 		struct HiZ
 		{
+			static const uint16_t __address = 3;
 			static const uint16_t dflt = 0b0; // 1'b0
 			static const uint16_t mask = 0b0010000000000000; // [13]
 		};
@@ -281,6 +630,7 @@ public:
 		 */
 		struct AVG
 		{
+			static const uint16_t __address = 3;
 			static const uint16_t dflt = 0b00; // 2'b0
 			static const uint16_t mask = 0b0001100000000000; // [11,12]
 			static const uint16_t AVG1x = 0b00; // 
@@ -291,6 +641,7 @@ public:
 		/* Bits unused_0: */
 		struct unused_0
 		{
+			static const uint16_t __address = 3;
 			static const uint16_t dflt = 0b10; // 2'b10
 			static const uint16_t mask = 0b0000011000000000; // [9,10]
 		};
@@ -310,6 +661,7 @@ public:
 		 */
 		struct VCOM_
 		{
+			static const uint16_t __address = 3;
 			static const uint16_t dflt = 0b001111101; // 9'b1111101
 			static const uint16_t mask = 0b0000000111111111; // [0,1,2,3,4,5,6,7,8]
 		};
@@ -318,13 +670,13 @@ public:
 	/* Set register VCOM */
 	void setVCOM(uint16_t value)
 	{
-		write(VCOM::__address, value, 16);
+		cachedWrite(VCOM::__address, value, 16);
 	}
 	
 	/* Get register VCOM */
 	uint16_t getVCOM()
 	{
-		return read16(VCOM::__address, 16);
+		return cachedRead16(VCOM::__address, 16);
 	}
 	
 	
@@ -347,6 +699,7 @@ public:
 		/* Panel temperature-change interrupt enable */
 		struct DTX_EN
 		{
+			static const uint16_t __address = 5;
 			static const uint8_t dflt = 0b0; // 1'b0
 			static const uint8_t mask = 0b10000000; // [7]
 		};
@@ -354,6 +707,7 @@ public:
 		/* Thermal shutdown interrupt enable */
 		struct TSD_EN
 		{
+			static const uint16_t __address = 5;
 			static const uint8_t dflt = 0b1; // 1'b1
 			static const uint8_t mask = 0b01000000; // [6]
 		};
@@ -361,6 +715,7 @@ public:
 		/* Thermal shutdown early warning enable */
 		struct HOT_EN
 		{
+			static const uint16_t __address = 5;
 			static const uint8_t dflt = 0b1; // 1'b1
 			static const uint8_t mask = 0b00100000; // [5]
 		};
@@ -368,6 +723,7 @@ public:
 		/* Thermistor hot interrupt enable */
 		struct TMST_HOT_EN
 		{
+			static const uint16_t __address = 5;
 			static const uint8_t dflt = 0b1; // 1'b1
 			static const uint8_t mask = 0b00010000; // [4]
 		};
@@ -375,6 +731,7 @@ public:
 		/* Thermistor cold interrupt enable */
 		struct TMST_COLD_EN
 		{
+			static const uint16_t __address = 5;
 			static const uint8_t dflt = 0b1; // 1'b1
 			static const uint8_t mask = 0b00001000; // [3]
 		};
@@ -382,6 +739,7 @@ public:
 		/* VIN under voltage detect interrupt enable */
 		struct UVLO_EN
 		{
+			static const uint16_t __address = 5;
 			static const uint8_t dflt = 0b1; // 1'b1
 			static const uint8_t mask = 0b00000100; // [2]
 		};
@@ -389,6 +747,7 @@ public:
 		/* VCOM acquisition complete interrupt enable */
 		struct ACQC_EN
 		{
+			static const uint16_t __address = 5;
 			static const uint8_t dflt = 0b1; // 1'b1
 			static const uint8_t mask = 0b00000010; // [1]
 		};
@@ -396,6 +755,7 @@ public:
 		/* VCOM programming complete interrupt enable */
 		struct PRGC_EN
 		{
+			static const uint16_t __address = 5;
 			static const uint8_t dflt = 0b1; // 1'b1
 			static const uint8_t mask = 0b00000001; // [0]
 		};
@@ -404,13 +764,13 @@ public:
 	/* Set register INT_EN1 */
 	void setINT_EN1(uint8_t value)
 	{
-		write(INT_EN1::__address, value, 8);
+		cachedWrite(INT_EN1::__address, value, 8);
 	}
 	
 	/* Get register INT_EN1 */
 	uint8_t getINT_EN1()
 	{
-		return read8(INT_EN1::__address, 8);
+		return cachedRead8(INT_EN1::__address, 8);
 	}
 	
 	
@@ -433,6 +793,7 @@ public:
 		/* Positive boost converter under voltage detect interrupt enable */
 		struct VBUVEN
 		{
+			static const uint16_t __address = 6;
 			static const uint8_t dflt = 0b1; // 1'b1
 			static const uint8_t mask = 0b10000000; // [7]
 		};
@@ -440,6 +801,7 @@ public:
 		/* VDDH under voltage detect interrupt enable */
 		struct VDDHUVEN
 		{
+			static const uint16_t __address = 6;
 			static const uint8_t dflt = 0b1; // 1'b1
 			static const uint8_t mask = 0b01000000; // [6]
 		};
@@ -447,6 +809,7 @@ public:
 		/* Inverting buck-boost converter under voltage detect interrupt enable */
 		struct VNUV_EN
 		{
+			static const uint16_t __address = 6;
 			static const uint8_t dflt = 0b1; // 1'b1
 			static const uint8_t mask = 0b00100000; // [5]
 		};
@@ -454,6 +817,7 @@ public:
 		/* VPOS under voltage detect interrupt enable */
 		struct VPOSUVEN
 		{
+			static const uint16_t __address = 6;
 			static const uint8_t dflt = 0b1; // 1'b1
 			static const uint8_t mask = 0b00010000; // [4]
 		};
@@ -461,6 +825,7 @@ public:
 		/* VEE under Voltage detect interrupt enable */
 		struct VEEUVEN
 		{
+			static const uint16_t __address = 6;
 			static const uint8_t dflt = 0b1; // 1'b1
 			static const uint8_t mask = 0b00001000; // [3]
 		};
@@ -468,6 +833,7 @@ public:
 		/* VCOM FAULT interrupt enable */
 		struct VCOMFEN
 		{
+			static const uint16_t __address = 6;
 			static const uint8_t dflt = 0b1; // 1'b1
 			static const uint8_t mask = 0b00000100; // [2]
 		};
@@ -475,6 +841,7 @@ public:
 		/* VNEG under Voltage detect interrupt enable */
 		struct VNEGUVEN
 		{
+			static const uint16_t __address = 6;
 			static const uint8_t dflt = 0b1; // 1'b1
 			static const uint8_t mask = 0b00000010; // [1]
 		};
@@ -482,6 +849,7 @@ public:
 		/* Temperature ADC end of conversion interrupt enable */
 		struct EOCEN
 		{
+			static const uint16_t __address = 6;
 			static const uint8_t dflt = 0b1; // 1'b1
 			static const uint8_t mask = 0b00000001; // [0]
 		};
@@ -490,13 +858,13 @@ public:
 	/* Set register INT_EN2 */
 	void setINT_EN2(uint8_t value)
 	{
-		write(INT_EN2::__address, value, 8);
+		cachedWrite(INT_EN2::__address, value, 8);
 	}
 	
 	/* Get register INT_EN2 */
 	uint8_t getINT_EN2()
 	{
-		return read8(INT_EN2::__address, 8);
+		return cachedRead8(INT_EN2::__address, 8);
 	}
 	
 	
@@ -521,18 +889,21 @@ public:
 		 */
 		struct DTX
 		{
+			static const uint16_t __address = 7;
 			static const uint8_t mask = 0b10000000; // [7]
 		};
 		/* Bits TSD: */
 		/* Thermal shutdown interrupt */
 		struct TSD
 		{
+			static const uint16_t __address = 7;
 			static const uint8_t mask = 0b01000000; // [6]
 		};
 		/* Bits HOT: */
 		/* Thermal shutdown early warning */
 		struct HOT
 		{
+			static const uint16_t __address = 7;
 			static const uint8_t mask = 0b00100000; // [5]
 		};
 		/* Bits TMST_HOT: */
@@ -542,6 +913,7 @@ public:
 		 */
 		struct TMST_HOT
 		{
+			static const uint16_t __address = 7;
 			static const uint8_t mask = 0b00010000; // [4]
 		};
 		/* Bits TMST_COLD: */
@@ -551,24 +923,28 @@ public:
 		 */
 		struct TMST_COLD
 		{
+			static const uint16_t __address = 7;
 			static const uint8_t mask = 0b00001000; // [3]
 		};
 		/* Bits UVLO: */
 		/* VIN under voltage detect interrupt. 1 - input voltage is below UVLO threshold  */
 		struct UVLO
 		{
+			static const uint16_t __address = 7;
 			static const uint8_t mask = 0b00000100; // [2]
 		};
 		/* Bits ACQC: */
 		/* VCOM acquisition complete */
 		struct ACQC
 		{
+			static const uint16_t __address = 7;
 			static const uint8_t mask = 0b00000010; // [1]
 		};
 		/* Bits PRGC: */
 		/* VCOM programming complete */
 		struct PRGC
 		{
+			static const uint16_t __address = 7;
 			static const uint8_t mask = 0b00000001; // [0]
 		};
 	};
@@ -576,13 +952,13 @@ public:
 	/* Set register INT1 */
 	void setINT1(uint8_t value)
 	{
-		write(INT1::__address, value, 8);
+		cachedWrite(INT1::__address, value, 8);
 	}
 	
 	/* Get register INT1 */
 	uint8_t getINT1()
 	{
-		return read8(INT1::__address, 8);
+		return cachedRead8(INT1::__address, 8);
 	}
 	
 	
@@ -607,12 +983,14 @@ public:
 		 */
 		struct VB_UV
 		{
+			static const uint16_t __address = 8;
 			static const uint8_t mask = 0b10000000; // [7]
 		};
 		/* Bits VDDH_UV: */
 		/* VDDH under voltage detect interrupt on VDDH charge pump  */
 		struct VDDH_UV
 		{
+			static const uint16_t __address = 8;
 			static const uint8_t mask = 0b01000000; // [6]
 		};
 		/* Bits VN_UV: */
@@ -622,18 +1000,21 @@ public:
 		 */
 		struct VN_UV
 		{
+			static const uint16_t __address = 8;
 			static const uint8_t mask = 0b00100000; // [5]
 		};
 		/* Bits VPOS_UV: */
 		/* VPOS undervoltage detect interrupt 1 - undervoltage on LDO1(VPOS) detected  */
 		struct VPOS_UV
 		{
+			static const uint16_t __address = 8;
 			static const uint8_t mask = 0b00010000; // [4]
 		};
 		/* Bits VEE_UV: */
 		/* VEE undervoltage detect interrupt 1 - undervoltage on VEE charge pump detected  */
 		struct VEE_UV
 		{
+			static const uint16_t __address = 8;
 			static const uint8_t mask = 0b00001000; // [3]
 		};
 		/* Bits VCOMF: */
@@ -643,12 +1024,14 @@ public:
 		 */
 		struct VCOMF
 		{
+			static const uint16_t __address = 8;
 			static const uint8_t mask = 0b00000100; // [2]
 		};
 		/* Bits VNEG_UV: */
 		/* VNEG undervoltage detect interrupt  1 - undervoltage on LDO2(VNEG) detected  */
 		struct VNEG_UV
 		{
+			static const uint16_t __address = 8;
 			static const uint8_t mask = 0b00000010; // [1]
 		};
 		/* Bits EOC: */
@@ -658,6 +1041,7 @@ public:
 		 */
 		struct EOC
 		{
+			static const uint16_t __address = 8;
 			static const uint8_t mask = 0b00000001; // [0]
 		};
 	};
@@ -665,13 +1049,48 @@ public:
 	/* Set register INT2 */
 	void setINT2(uint8_t value)
 	{
-		write(INT2::__address, value, 8);
+		cachedWrite(INT2::__address, value, 8);
 	}
 	
 	/* Get register INT2 */
 	uint8_t getINT2()
 	{
-		return read8(INT2::__address, 8);
+		return cachedRead8(INT2::__address, 8);
+	}
+	
+	/*
+	 * INT1 and INT2 fetched in one 16 bit auto-increment transfer, byteorder little:
+	 * INT1 in the low byte, INT2 in the high byte.
+	 * NOTE: Reading clears both registers.
+	 */
+	struct Interrupts
+	{
+		uint16_t value;
+		
+		/* Is bit field F of INT1 or INT2 set, e.g. has<INT1::TSD>() */
+		template <class F>
+		bool has() const
+		{
+			return value & (F::__address == INT2::__address ? F::mask << 8 : F::mask);
+		}
+		
+		uint8_t int1() const
+		{
+			return value & 0xff;
+		}
+		
+		uint8_t int2() const
+		{
+			return value >> 8;
+		}
+	};
+	
+	/* Get registers INT1 and INT2 */
+	Interrupts getInterrupts()
+	{
+		Interrupts interrupts;
+		interrupts.value = this->read16(INT1::__address, 16);
+		return interrupts;
 	}
 	
 	
@@ -693,6 +1112,7 @@ public:
 		/* VDDH power-up order  */
 		struct VDDH_UP
 		{
+			static const uint16_t __address = 9;
 			static const uint8_t dflt = 0b11; // 2'b11
 			static const uint8_t mask = 0b11000000; // [6,7]
 			static const uint8_t STROBE1 = 0b00; // 
@@ -704,6 +1124,7 @@ public:
 		/* VPOS power-up order  */
 		struct VPOS_UP
 		{
+			static const uint16_t __address = 9;
 			static const uint8_t dflt = 0b10; // 2'b10
 			static const uint8_t mask = 0b00110000; // [4,5]
 			static const uint8_t STROBE1 = 0b00; // 
@@ -715,6 +1136,7 @@ public:
 		/* VEE power-up order  */
 		struct VEE_UP
 		{
+			static const uint16_t __address = 9;
 			static const uint8_t dflt = 0b01; // 2'b1
 			static const uint8_t mask = 0b00001100; // [2,3]
 			static const uint8_t STROBE1 = 0b00; // 
@@ -726,6 +1148,7 @@ public:
 		/* VNEG power-up order  */
 		struct VNEG_UP
 		{
+			static const uint16_t __address = 9;
 			static const uint8_t dflt = 0b00; // 2'b0
 			static const uint8_t mask = 0b00000011; // [0,1]
 			static const uint8_t STROBE1 = 0b00; // 
@@ -738,13 +1161,13 @@ public:
 	/* Set register UPSEQ0 */
 	void setUPSEQ0(uint8_t value)
 	{
-		write(UPSEQ0::__address, value, 8);
+		cachedWrite(UPSEQ0::__address, value, 8);
 	}
 	
 	/* Get register UPSEQ0 */
 	uint8_t getUPSEQ0()
 	{
-		return read8(UPSEQ0::__address, 8);
+		return cachedRead8(UPSEQ0::__address, 8);
 	}
 	
 	
@@ -766,6 +1189,7 @@ public:
 		/* DLY4 delay time set; defines the delay time from STROBE3 to STROBE4  */
 		struct UDLY4
 		{
+			static const uint16_t __address = 10;
 			static const uint8_t dflt = 0b01; // 2'b1
 			static const uint8_t mask = 0b11000000; // [6,7]
 			static const uint8_t delay3ms = 0b00; // 
@@ -777,6 +1201,7 @@ public:
 		/* DLY3 delay time set; defines the delay time from STROBE2 to STROBE3  */
 		struct UDLY3
 		{
+			static const uint16_t __address = 10;
 			static const uint8_t dflt = 0b01; // 2'b1
 			static const uint8_t mask = 0b00110000; // [4,5]
 			static const uint8_t delay3ms = 0b00; // 
@@ -788,6 +1213,7 @@ public:
 		/* DLY2 delay time set; defines the delay time from STROBE1 to STROBE2   */
 		struct UDLY2
 		{
+			static const uint16_t __address = 10;
 			static const uint8_t dflt = 0b01; // 2'b1
 			static const uint8_t mask = 0b00001100; // [2,3]
 			static const uint8_t delay3ms = 0b00; // 
@@ -799,6 +1225,7 @@ public:
 		/* DLY1 delay time set; defines the delay time from VN_PG high to STROBE1  */
 		struct UDLY
 		{
+			static const uint16_t __address = 10;
 			static const uint8_t dflt = 0b01; // 2'b1
 			static const uint8_t mask = 0b00000011; // [0,1]
 			static const uint8_t delay3ms = 0b00; // 
@@ -811,13 +1238,13 @@ public:
 	/* Set register UPSEQ1 */
 	void setUPSEQ1(uint8_t value)
 	{
-		write(UPSEQ1::__address, value, 8);
+		cachedWrite(UPSEQ1::__address, value, 8);
 	}
 	
 	/* Get register UPSEQ1 */
 	uint8_t getUPSEQ1()
 	{
-		return read8(UPSEQ1::__address, 8);
+		return cachedRead8(UPSEQ1::__address, 8);
 	}
 	
 	
@@ -839,6 +1266,7 @@ public:
 		/* VDDH power-down order  */
 		struct VDDH_DWN
 		{
+			static const uint16_t __address = 11;
 			static const uint8_t dflt = 0b00; // 2'b0
 			static const uint8_t mask = 0b11000000; // [6,7]
 			static const uint8_t STROBE1 = 0b00; // 
@@ -850,6 +1278,7 @@ public:
 		/* VPOS power-down order  */
 		struct VPOS_DWN
 		{
+			static const uint16_t __address = 11;
 			static const uint8_t dflt = 0b01; // 2'b1
 			static const uint8_t mask = 0b00110000; // [4,5]
 			static const uint8_t STROBE1 = 0b00; // 
@@ -861,6 +1290,7 @@ public:
 		/* VEE power-down order  */
 		struct VEE_DWN
 		{
+			static const uint16_t __address = 11;
 			static const uint8_t dflt = 0b11; // 2'b11
 			static const uint8_t mask = 0b00001100; // [2,3]
 			static const uint8_t STROBE1 = 0b00; // 
@@ -872,6 +1302,7 @@ public:
 		/* VNEG power-down order  */
 		struct VNEG_DWN
 		{
+			static const uint16_t __address = 11;
 			static const uint8_t dflt = 0b10; // 2'b10
 			static const uint8_t mask = 0b00000011; // [0,1]
 			static const uint8_t STROBE1 = 0b00; // 
@@ -884,13 +1315,13 @@ public:
 	/* Set register DWNSEQ0 */
 	void setDWNSEQ0(uint8_t value)
 	{
-		write(DWNSEQ0::__address, value, 8);
+		cachedWrite(DWNSEQ0::__address, value, 8);
 	}
 	
 	/* Get register DWNSEQ0 */
 	uint8_t getDWNSEQ0()
 	{
-		return read8(DWNSEQ0::__address, 8);
+		return cachedRead8(DWNSEQ0::__address, 8);
 	}
 	
 	
@@ -912,6 +1343,7 @@ public:
 		/* DLY4 delay time set; defines the delay time from STROBE3 to STROBE4  */
 		struct DDLY4
 		{
+			static const uint16_t __address = 12;
 			static const uint8_t dflt = 0b11; // 2'b11
 			static const uint8_t mask = 0b11000000; // [6,7]
 			static const uint8_t delay6ms = 0b00; // 
@@ -923,6 +1355,7 @@ public:
 		/* DLY3 delay time set; defines the delay time from STROBE2 to STROBE3  */
 		struct DDLY3
 		{
+			static const uint16_t __address = 12;
 			static const uint8_t dflt = 0b10; // 2'b10
 			static const uint8_t mask = 0b00110000; // [4,5]
 			static const uint8_t delay6ms = 0b00; // 
@@ -934,6 +1367,7 @@ public:
 		/* DLY2 delay time set; defines the delay time from STROBE1 to STROBE2  */
 		struct DDLY2
 		{
+			static const uint16_t __address = 12;
 			static const uint8_t dflt = 0b00; // 2'b0
 			static const uint8_t mask = 0b00001100; // [2,3]
 			static const uint8_t delay6ms = 0b00; // 
@@ -945,6 +1379,7 @@ public:
 		/* DLY2 delay time set; defines the delay time from WAKEUP low to STROBE1  */
 		struct DDLY1
 		{
+			static const uint16_t __address = 12;
 			static const uint8_t dflt = 0b0; // 1'b0
 			static const uint8_t mask = 0b00000010; // [1]
 			static const uint8_t delay3ms = 0b0; // 
@@ -954,6 +1389,7 @@ public:
 		/* At power-down delay time DLY2[1:0], DLY3[1:0], DLY4[1:0] are multiplied with DFCTR[1:0]  */
 		struct DFCTR
 		{
+			static const uint16_t __address = 12;
 			static const uint8_t dflt = 0b0; // 1'b0
 			static const uint8_t mask = 0b00000001; // [0]
 			static const uint8_t multiply1x = 0b0; // 
@@ -964,13 +1400,13 @@ public:
 	/* Set register DWNSEQ1 */
 	void setDWNSEQ1(uint8_t value)
 	{
-		write(DWNSEQ1::__address, value, 8);
+		cachedWrite(DWNSEQ1::__address, value, 8);
 	}
 	
 	/* Get register DWNSEQ1 */
 	uint8_t getDWNSEQ1()
 	{
-		return read8(DWNSEQ1::__address, 8);
+		return cachedRead8(DWNSEQ1::__address, 8);
 	}
 	
 	
@@ -995,12 +1431,14 @@ public:
 		 */
 		struct READ_THERM
 		{
+			static const uint16_t __address = 13;
 			static const uint8_t dflt = 0b0; // 1'b0
 			static const uint8_t mask = 0b10000000; // [7]
 		};
 		/* Bits unused_0: */
 		struct unused_0
 		{
+			static const uint16_t __address = 13;
 			static const uint8_t dflt = 0b0; // 1'b0
 			static const uint8_t mask = 0b01000000; // [6]
 		};
@@ -1008,24 +1446,28 @@ public:
 		/* ADC conversion done flag */
 		struct CONV_END
 		{
+			static const uint16_t __address = 13;
 			static const uint8_t dflt = 0b1; // 1'b1
 			static const uint8_t mask = 0b00100000; // [5]
 		};
 		/* Bits unused_1: */
 		struct unused_1
 		{
+			static const uint16_t __address = 13;
 			static const uint8_t dflt = 0b0; // 1'b0
 			static const uint8_t mask = 0b00010000; // [4]
 		};
 		/* Bits unused_2: */
 		struct unused_2
 		{
+			static const uint16_t __address = 13;
 			static const uint8_t dflt = 0b0; // 1'b0
 			static const uint8_t mask = 0b00001000; // [3]
 		};
 		/* Bits unused_3: */
 		struct unused_3
 		{
+			static const uint16_t __address = 13;
 			static const uint8_t dflt = 0b0; // 1'b0
 			static const uint8_t mask = 0b00000100; // [2]
 		};
@@ -1038,6 +1480,7 @@ public:
 		 */
 		struct DT
 		{
+			static const uint16_t __address = 13;
 			static const uint8_t dflt = 0b00; // 2'b0
 			static const uint8_t mask = 0b00000011; // [0,1]
 			static const uint8_t TEMP2C = 0b00; // 2°C
@@ -1050,13 +1493,13 @@ public:
 	/* Set register TMST1 */
 	void setTMST1(uint8_t value)
 	{
-		write(TMST1::__address, value, 8);
+		cachedWrite(TMST1::__address, value, 8);
 	}
 	
 	/* Get register TMST1 */
 	uint8_t getTMST1()
 	{
-		return read8(TMST1::__address, 8);
+		return cachedRead8(TMST1::__address, 8);
 	}
 	
 	
@@ -1084,6 +1527,7 @@ public:
 		 */
 		struct TMST_COLD
 		{
+			static const uint16_t __address = 14;
 			static const uint8_t dflt = 0b0111; // 4'b111
 			static const uint8_t mask = 0b11110000; // [4,5,6,7]
 		};
@@ -1096,6 +1540,7 @@ public:
 		 */
 		struct TMST_HOT
 		{
+			static const uint16_t __address = 14;
 			static const uint8_t dflt = 0b1000; // 4'b1000
 			static const uint8_t mask = 0b00001111; // [0,1,2,3]
 		};
@@ -1104,13 +1549,13 @@ public:
 	/* Set register TMST2 */
 	void setTMST2(uint8_t value)
 	{
-		write(TMST2::__address, value, 8);
+		cachedWrite(TMST2::__address, value, 8);
 	}
 	
 	/* Get register TMST2 */
 	uint8_t getTMST2()
 	{
-		return read8(TMST2::__address, 8);
+		return cachedRead8(TMST2::__address, 8);
 	}
 	
 	
@@ -1132,6 +1577,7 @@ public:
 		/* Positive boost converter power good. 1 - DCDC1 is in regulation */
 		struct VB_PG
 		{
+			static const uint16_t __address = 15;
 			static const uint8_t dflt = 0b0; // 1'b0
 			static const uint8_t mask = 0b10000000; // [7]
 		};
@@ -1139,6 +1585,7 @@ public:
 		/* VDDH power good. 1 - VDDH charge pump is in regulation */
 		struct VDDH_PG
 		{
+			static const uint16_t __address = 15;
 			static const uint8_t dflt = 0b0; // 1'b0
 			static const uint8_t mask = 0b01000000; // [6]
 		};
@@ -1146,6 +1593,7 @@ public:
 		/* Inverting buck-boost power good. 1 - DCDC2 is in regulation */
 		struct VN_PG
 		{
+			static const uint16_t __address = 15;
 			static const uint8_t dflt = 0b0; // 1'b0
 			static const uint8_t mask = 0b00100000; // [5]
 		};
@@ -1153,6 +1601,7 @@ public:
 		/* VPOS power good. 1 - LDO1(VPOS) is in regulation */
 		struct VPOS_PG
 		{
+			static const uint16_t __address = 15;
 			static const uint8_t dflt = 0b0; // 1'b0
 			static const uint8_t mask = 0b00010000; // [4]
 		};
@@ -1160,12 +1609,14 @@ public:
 		/* VEE power good. 1 - VEE charge pump is in regulation */
 		struct VEE_PG
 		{
+			static const uint16_t __address = 15;
 			static const uint8_t dflt = 0b0; // 1'b0
 			static const uint8_t mask = 0b00001000; // [3]
 		};
 		/* Bits unused_0: */
 		struct unused_0
 		{
+			static const uint16_t __address = 15;
 			static const uint8_t dflt = 0b0; // 1'b0
 			static const uint8_t mask = 0b00000100; // [2]
 		};
@@ -1173,12 +1624,14 @@ public:
 		/* VNEG power good. 1 - LDO2(VNEG) is in regulation */
 		struct VNEG_PG
 		{
+			static const uint16_t __address = 15;
 			static const uint8_t dflt = 0b0; // 1'b0
 			static const uint8_t mask = 0b00000010; // [1]
 		};
 		/* Bits unused_1: */
 		struct unused_1
 		{
+			static const uint16_t __address = 15;
 			static const uint8_t dflt = 0b0; // 1'b0
 			static const uint8_t mask = 0b00000001; // [0]
 		};
@@ -1187,13 +1640,13 @@ public:
 	/* Set register PG */
 	void setPG(uint8_t value)
 	{
-		write(PG::__address, value, 8);
+		cachedWrite(PG::__address, value, 8);
 	}
 	
 	/* Get register PG */
 	uint8_t getPG()
 	{
-		return read8(PG::__address, 8);
+		return cachedRead8(PG::__address, 8);
 	}
 	
 	
@@ -1214,6 +1667,7 @@ public:
 		/* Bits MJREV: */
 		struct MJREV
 		{
+			static const uint16_t __address = 16;
 			static const uint8_t dflt = 0b01; // 2'b1
 			static const uint8_t mask = 0b11000000; // [6,7]
 			static const uint8_t TPS65185_1p0 = 0b00; // 
@@ -1223,12 +1677,14 @@ public:
 		/* Bits MNREV: */
 		struct MNREV
 		{
+			static const uint16_t __address = 16;
 			static const uint8_t dflt = 0b00; // 2'b0
 			static const uint8_t mask = 0b00110000; // [4,5]
 		};
 		/* Bits VERSION: */
 		struct VERSION
 		{
+			static const uint16_t __address = 16;
 			static const uint8_t dflt = 0b0101; // 4'b101
 			static const uint8_t mask = 0b00001111; // [0,1,2,3]
 		};
@@ -1237,13 +1693,88 @@ public:
 	/* Set register REVID */
 	void setREVID(uint8_t value)
 	{
-		write(REVID::__address, value, 8);
+		cachedWrite(REVID::__address, value, 8);
 	}
 	
 	/* Get register REVID */
 	uint8_t getREVID()
 	{
-		return read8(REVID::__address, 8);
+		return cachedRead8(REVID::__address, 8);
+	}
+	
+private:
+	uint8_t cachedRead(uint16_t address, uint8_t *)
+	{
+		return cachedRead8(address, 8);
+	}
+	
+	uint16_t cachedRead(uint16_t address, uint16_t *)
+	{
+		return cachedRead16(address, 16);
+	}
+	
+	uint8_t uncachedRead(uint16_t address, uint8_t *)
+	{
+		return this->read8(address, 8);
+	}
+	
+	uint16_t uncachedRead(uint16_t address, uint16_t *)
+	{
+		return this->read16(address, 16);
+	}
+	
+	/* Self-clearing bits to strip before a read-modify-write */
+	static uint8_t volatileBits(uint16_t address, uint8_t *)
+	{
+		return isCacheable(address) ? volatileMask(address) : 0;
+	}
+	
+	static uint16_t volatileBits(uint16_t address, uint16_t *)
+	{
+		return volatileBits(address, (uint8_t *)0) | (uint16_t(volatileBits(address + 1, (uint8_t *)0)) << 8);
+	}
+	
+	bool isCached(uint16_t address) const
+	{
+		return (cache_valid >> address) & 1;
 	}
 	
+	/* Record a value read from the bus */
+	void store(uint16_t address, uint8_t value)
+	{
+		shadow[address] = value;
+		cache_valid |= 1UL << address;
+	}
+	
+	/* Record a value written to the bus */
+	void update(uint16_t address, uint8_t value)
+	{
+		/* The device ignores writes to REVID */
+		if (address == REVID::__address)
+			return;
+		if (!isCacheable(address) || (value & volatileMask(address)))
+			invalidateCache(address);
+		else
+			store(address, value);
+		if (address == VCOM::__address + 1)
+		{
+			/* Acquisition and programming rewrite VCOM[7:0] */
+			if (value & volatileMask(address))
+				invalidateCache(VCOM::__address);
+			/* VCOM programming forces the device into STANDBY */
+			if (value & (VCOM::PROG::mask >> 8))
+				invalidateCache(ENABLE::__address);
+		}
+	}
+	
+	bool cache_enabled;
+	uint32_t cache_valid;
+	uint8_t shadow[__registers];
 };
+
+/* TPS65185 with virtual register access, see TPS65185_Transport */
+class TPS65185_Base : public TPS65185_Device<TPS65185_Transport>
+{
+};
+
+#endif
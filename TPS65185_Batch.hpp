@@ -0,0 +1,121 @@
+/*
+ * name:        TPS65185
+ * description: Batched register writes for the TPS65185
+ * manuf:       Texas Instruments
+ * version:     0.1
+ * url:         http://www.ti.com/lit/ds/symlink/tps65185.pdf
+ * date:        2016-08-01
+ * author       https://chisl.io/
+ * file:        TPS65185_Batch.hpp
+ */
+
+#ifndef TPS65185_BATCH_HPP
+#define TPS65185_BATCH_HPP
+
+#include "TPS65185.hpp"
+
+/*
+ * Collects register writes and issues them in as few bus transactions as possible.
+ * write() and set<F>() only record the new value; a later write to the same register
+ * replaces it. commit() sends the pending registers in ascending address order, each run
+ * of consecutive addresses as one auto-increment burst through cachedWriteBurst(), e.g.
+ * UPSEQ0..TMST2 (addresses 9..14) in a single transaction.
+ * As commit() reorders writes, do not batch writes whose order matters, such as ENABLE
+ * after the sequence registers; commit those batches separately.
+ * set<F>() starts from the pending value of the register, or from the device through
+ * the shadow cache, so fields of one register merge into one write.
+ */
+template <class Device>
+class TPS65185_Batch
+{
+public:
+	explicit TPS65185_Batch(Device &device) : device(device), pending(0)
+	{
+	}
+	
+	/* Record an 8 bit register write; false, recording nothing, past the register file */
+	bool write(uint16_t address, uint8_t value)
+	{
+		if (address >= Device::__registers)
+			return false;
+		data[address] = value;
+		pending |= 1UL << address;
+		return true;
+	}
+	
+	/* Record a 16 bit register write, byteorder little; false if either byte is out of range */
+	bool write(uint16_t address, uint16_t value)
+	{
+		if (address + 1 >= Device::__registers)
+			return false;
+		write(address, uint8_t(value & 0xff));
+		write(address + 1, uint8_t(value >> 8));
+		return true;
+	}
+	
+	/* Record a write of bit field F, e.g. set<Device::UPSEQ1::UDLY2>(1) */
+	template <class F>
+	void set(typename TPS65185_Field<F>::type value)
+	{
+		typedef typename TPS65185_Field<F>::type type;
+		type reg = current(F::__address);
+		if (sizeof(type) == 2)
+			reg |= type(current(F::__address + 1)) << 8;
+		write(F::__address, Device::template insert<F>(reg, value));
+	}
+	
+	/* Send all pending writes; returns the number of bus transactions */
+	uint8_t commit()
+	{
+		uint8_t transactions = 0;
+		uint16_t address = 0;
+		while (pending)
+		{
+			while (!((pending >> address) & 1))
+				address++;
+			uint16_t count = 0;
+			while ((pending >> (address + count)) & 1)
+				count++;
+			if (count == 1)
+				device.cachedWrite(address, data[address]);
+			else
+				device.cachedWriteBurst(address, data + address, count);
+			pending &= ~(((1UL << count) - 1) << address);
+			address += count;
+			transactions++;
+		}
+		return transactions;
+	}
+	
+	/* Drop all pending writes */
+	void discard()
+	{
+		pending = 0;
+	}
+	
+	/* Is a write to register address pending? */
+	bool isPending(uint16_t address) const
+	{
+		return address < Device::__registers && ((pending >> address) & 1);
+	}
+	
+	bool isEmpty() const
+	{
+		return pending == 0;
+	}
+	
+private:
+	/* Register value a field write starts from; self-clearing bits are written as 0 */
+	uint8_t current(uint16_t address)
+	{
+		if (isPending(address))
+			return data[address];
+		return device.cachedRead8(address) & ~Device::volatileMask(address);
+	}
+	
+	Device &device;
+	uint32_t pending;
+	uint8_t data[Device::__registers];
+};
+
+#endif
@@ -0,0 +1,195 @@
+/*
+ * name:        TPS65185
+ * description: Non-blocking VCOM kick-back measurement for the TPS65185
+ * manuf:       Texas Instruments
+ * version:     0.1
+ * url:         http://www.ti.com/lit/ds/symlink/tps65185.pdf
+ * date:        2016-08-01
+ * author       https://chisl.io/
+ * file:        TPS65185_Calibration.hpp
+ */
+
+#ifndef TPS65185_CALIBRATION_HPP
+#define TPS65185_CALIBRATION_HPP
+
+#include "TPS65185.hpp"
+
+/*
+ * Runs a batch of kick-back voltage measurements without blocking. Each measurement sets
+ * VCOM::HiZ, the requested VCOM::AVG and VCOM::ACQ in one write, then completes on
+ * INT1::ACQC (subscribe onACQC()) or when tick() sees ACQ cleared, and reads VCOM[8:0].
+ * When the batch is done the VCOM register is restored to its value from before the
+ * batch, the statistics are computed and the callback runs. An acquisition still running
+ * timeout_us << AVG after it started ends the batch the same way, with status TIMEOUT and
+ * only the samples taken before it.
+ * Codes are VCOM[8:0] units, i.e. -10 mV each. Times are in microseconds.
+ */
+template <class Device, int MaxSamples = 8>
+class TPS65185_Calibration
+{
+public:
+	typedef typename Device::VCOM VCOM;
+	
+	enum Status { SUCCESS, TIMEOUT };
+	
+	struct Result
+	{
+		Status status;
+		uint8_t count;
+		uint8_t avg[MaxSamples];      // VCOM::AVG setting of each sample
+		uint16_t sample[MaxSamples];  // measured VCOM[8:0]
+		uint16_t mean;                // rounded
+		uint16_t min;
+		uint16_t max;
+		
+		uint16_t spread() const
+		{
+			return max - min;
+		}
+	};
+	
+	typedef void (*Callback)(void *context, const Result &result);
+	
+	explicit TPS65185_Calibration(Device &device, uint32_t poll_us = 1000, uint32_t timeout_us = 10000)
+		: device(device), poll_us(poll_us), timeout_us(timeout_us), callback(0), context(0), count(0),
+		  index(0), measuring(false), acqc(false), saved(0), next_poll(0), deadline(0)
+	{
+		result.status = SUCCESS;
+		result.count = 0;
+	}
+	
+	/* Start count measurements with the VCOM::AVG settings in avg; false if busy */
+	bool startBatch(uint32_t now, const uint8_t *avg, uint8_t count, Callback callback = 0, void *context = 0)
+	{
+		if (measuring || count == 0 || count > MaxSamples)
+			return false;
+		for (uint8_t i = 0; i < count; i++)
+			result.avg[i] = avg[i] & (VCOM::AVG::mask >> TPS65185_Field<typename VCOM::AVG>::shift);
+		this->count = count;
+		this->callback = callback;
+		this->context = context;
+		index = 0;
+		measuring = true;
+		saved = device.getVCOM() & ~(VCOM::ACQ::mask | VCOM::PROG::mask);
+		acquire(now);
+		return true;
+	}
+	
+	/* Start count measurements that all use the same VCOM::AVG setting */
+	bool start(uint32_t now, uint8_t avg, uint8_t count = 1, Callback callback = 0, void *context = 0)
+	{
+		uint8_t settings[MaxSamples];
+		for (uint8_t i = 0; i < count && i < MaxSamples; i++)
+			settings[i] = avg;
+		return startBatch(now, settings, count, callback, context);
+	}
+	
+	/* Advance the batch; polls VCOM::ACQ only when ACQC has not been signalled */
+	void tick(uint32_t now)
+	{
+		if (!measuring)
+			return;
+		if (acqc)
+			complete(now, device.read16(VCOM::__address, 16));
+		else if (int32_t(now - next_poll) >= 0)
+		{
+			/* ACQ is volatile: read it past the shadow cache */
+			uint16_t vcom = device.read16(VCOM::__address, 16);
+			if (!(vcom & VCOM::ACQ::mask))
+				complete(now, vcom);
+			else if (int32_t(now - deadline) >= 0)
+				finish(TIMEOUT);
+			else
+				next_poll = now + poll_us;
+		}
+	}
+	
+	/* Handler for INT1::ACQC, e.g. for TPS65185_Interrupts; completes on the next tick() */
+	static void onACQC(void *context, uint16_t events)
+	{
+		(void)events;
+		static_cast<TPS65185_Calibration *>(context)->acqc = true;
+	}
+	
+	bool isBusy() const
+	{
+		return measuring;
+	}
+	
+	/* Result of the last completed batch */
+	const Result &getResult() const
+	{
+		return result;
+	}
+	
+private:
+	void acquire(uint32_t now)
+	{
+		uint16_t vcom = Device::template insert<typename VCOM::HiZ>(saved, 1);
+		vcom = Device::template insert<typename VCOM::AVG>(vcom, result.avg[index]);
+		vcom = Device::template insert<typename VCOM::ACQ>(vcom, 1);
+		acqc = false;
+		next_poll = now + (uint32_t(poll_us) << result.avg[index]);
+		deadline = now + (timeout_us << result.avg[index]);
+		device.setVCOM(vcom);
+	}
+	
+	void complete(uint32_t now, uint16_t vcom)
+	{
+		acqc = false;
+		result.sample[index] = Device::template extract<typename VCOM::VCOM_>(vcom);
+		if (++index < count)
+		{
+			acquire(now);
+			return;
+		}
+		finish(SUCCESS);
+	}
+	
+	/* End the batch with the samples taken so far and restore HiZ/AVG */
+	void finish(Status status)
+	{
+		measuring = false;
+		acqc = false;
+		device.setVCOM(saved);
+		result.status = status;
+		statistics();
+		if (callback)
+			callback(context, result);
+	}
+	
+	void statistics()
+	{
+		uint32_t sum = 0;
+		result.count = index;
+		result.min = result.max = result.mean = 0;
+		if (index == 0)
+			return;
+		result.min = result.max = result.sample[0];
+		for (uint8_t i = 0; i < index; i++)
+		{
+			sum += result.sample[i];
+			if (result.sample[i] < result.min)
+				result.min = result.sample[i];
+			if (result.sample[i] > result.max)
+				result.max = result.sample[i];
+		}
+		result.mean = (sum + index / 2) / index;
+	}
+	
+	Device &device;
+	uint32_t poll_us;
+	uint32_t timeout_us;
+	Callback callback;
+	void *context;
+	uint8_t count;
+	uint8_t index;
+	bool measuring;
+	bool acqc;
+	uint16_t saved;
+	uint32_t next_poll;
+	uint32_t deadline;
+	Result result;
+};
+
+#endif
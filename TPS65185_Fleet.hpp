@@ -0,0 +1,296 @@
+/*
+ * name:        TPS65185
+ * description: Power sequencing of many TPS65185 on multiplexed buses
+ * manuf:       Texas Instruments
+ * version:     0.1
+ * url:         http://www.ti.com/lit/ds/symlink/tps65185.pdf
+ * date:        2016-08-01
+ * author       https://chisl.io/
+ * file:        TPS65185_Fleet.hpp
+ */
+
+#ifndef TPS65185_FLEET_HPP
+#define TPS65185_FLEET_HPP
+
+#include "TPS65185.hpp"
+#include "TPS65185_Batch.hpp"
+#include "TPS65185_Sequencer.hpp"
+
+/*
+ * Powers up to MaxDevices panels in parallel waves instead of one after another.
+ * Each device is added with the bus segment (e.g. I2C mux channel) it sits on and the
+ * inrush current it draws while its rails ramp. Devices are kept sorted by segment, and
+ * every pass over them (configuration, starting a wave, polling PG) selects each segment
+ * once, so a pass costs at most one mux switch per segment. configure() collects the
+ * register writes of each device in a TPS65185_Batch and commits it while the segment
+ * is selected, so a device's configuration costs a few bursts.
+ * Every device runs its own TPS65185_Sequencer. powerUp() starts as many devices as fit
+ * within the inrush limit; a device returns its share when its sequencer settles, and
+ * tick() then starts the next wave. Wall power-up time therefore grows with total inrush
+ * / limit rather than with the panel count. powerDown() has no inrush and stops all
+ * devices at once.
+ * The callback runs when every device has settled, with the number that timed out; a new
+ * powerUp()/powerDown() replaces the callback of one still running.
+ * Times are in microseconds, currents in any unit as long as they agree.
+ */
+template <class Device, int MaxDevices = 32>
+class TPS65185_Fleet
+{
+public:
+	typedef TPS65185_Sequencer<Device> Sequencer;
+	typedef typename Sequencer::State State;
+	typedef TPS65185_Batch<Device> Batch;
+	typedef void (*Select)(void *context, uint8_t segment);
+	typedef void (*Visitor)(void *context, Device &device);
+	typedef void (*Configure)(void *context, Device &device, Batch &batch);
+	typedef void (*Callback)(void *context, uint8_t failed);
+	
+	explicit TPS65185_Fleet(uint32_t inrush_limit, Select select = 0, void *select_context = 0,
+		uint32_t timeout_us = 500000, uint32_t poll_us = 1000)
+		: inrush_limit(inrush_limit), select(select), select_context(select_context), timeout_us(timeout_us),
+		  poll_us(poll_us), dcdc_us(0), callback(0), context(0), devices(0), segment(0), selected(false),
+		  pending(0), inrush(0), failed(0), waves(0)
+	{
+	}
+	
+	/* Add device on segment; false when all MaxDevices slots are taken */
+	bool add(Device &device, uint8_t segment, uint32_t inrush)
+	{
+		if (devices == MaxDevices)
+			return false;
+		int i = devices++;
+		for (; i > 0 && slots[i - 1].segment > segment; i--)
+			slots[i] = slots[i - 1];
+		slots[i].sequencer = Sequencer();
+		slots[i].sequencer.attach(device, timeout_us, poll_us);
+		slots[i].sequencer.setSoftStart(dcdc_us);
+		slots[i].segment = segment;
+		slots[i].inrush = inrush;
+		slots[i].queued = false;
+		slots[i].drawing = false;
+		return true;
+	}
+	
+	/* Call visitor for every device, segment by segment */
+	void forEach(Visitor visitor, void *context = 0)
+	{
+		for (int i = 0; i < devices; i++)
+		{
+			enter(slots[i].segment);
+			visitor(context, slots[i].sequencer.getDevice());
+		}
+	}
+	
+	/* Collect the register writes of every device in a batch and commit it, segment by segment */
+	void configure(Configure visitor, void *context = 0)
+	{
+		for (int i = 0; i < devices; i++)
+		{
+			enter(slots[i].segment);
+			Device &device = slots[i].sequencer.getDevice();
+			Batch batch(device);
+			visitor(context, device, batch);
+			batch.commit();
+		}
+	}
+	
+	/* Power up every device not on yet, in waves within the inrush limit */
+	void powerUp(uint32_t now, Callback callback = 0, void *context = 0)
+	{
+		begin(callback, context);
+		for (int i = 0; i < devices; i++)
+		{
+			State state = slots[i].sequencer.getState();
+			if (state != Sequencer::ON && state != Sequencer::POWERING_UP)
+			{
+				slots[i].queued = true;
+				pending++;
+			}
+		}
+		wave(now);
+		settle();
+	}
+	
+	/* Power down every device not off yet, all at once */
+	void powerDown(uint32_t now, Callback callback = 0, void *context = 0)
+	{
+		begin(callback, context);
+		for (int i = 0; i < devices; i++)
+			if (slots[i].sequencer.getState() != Sequencer::OFF)
+			{
+				Slot &slot = slots[i];
+				enter(slot.segment);
+				release(slot);
+				slot.sequencer.powerDown(now);
+			}
+		settle();
+	}
+	
+	/* Advance the sequencers that are due and start the next wave when inrush allows */
+	void tick(uint32_t now)
+	{
+		if (!isBusy())
+			return;
+		for (int i = 0; i < devices; i++)
+		{
+			Slot &slot = slots[i];
+			State state = slot.sequencer.getState();
+			if (!slot.sequencer.isBusy() || int32_t(now - slot.sequencer.nextPoll()) < 0)
+				continue;
+			enter(slot.segment);
+			slot.sequencer.tick(now);
+			if (slot.sequencer.isBusy())
+				continue;
+			release(slot);
+			if (slot.sequencer.getState() != (state == Sequencer::POWERING_UP ? Sequencer::ON : Sequencer::OFF))
+				failed++;
+		}
+		wave(now);
+		settle();
+	}
+	
+	/* DC-DC soft-start time of the board, added to the predicted power-up time */
+	void setSoftStart(uint32_t dcdc_us)
+	{
+		this->dcdc_us = dcdc_us;
+		for (int i = 0; i < devices; i++)
+			slots[i].sequencer.setSoftStart(dcdc_us);
+	}
+	
+	/* Next time tick() has work to do; only meaningful while busy */
+	uint32_t nextPoll() const
+	{
+		uint32_t next = 0;
+		bool first = true;
+		for (int i = 0; i < devices; i++)
+			if (slots[i].sequencer.isBusy() && (first || int32_t(slots[i].sequencer.nextPoll() - next) < 0))
+			{
+				next = slots[i].sequencer.nextPoll();
+				first = false;
+			}
+		return next;
+	}
+	
+	bool isBusy() const
+	{
+		if (pending)
+			return true;
+		for (int i = 0; i < devices; i++)
+			if (slots[i].sequencer.isBusy())
+				return true;
+		return false;
+	}
+	
+	int size() const
+	{
+		return devices;
+	}
+	
+	/* Device and state in segment order */
+	Device &getDevice(int index)
+	{
+		return slots[index].sequencer.getDevice();
+	}
+	
+	State getState(int index) const
+	{
+		return slots[index].sequencer.getState();
+	}
+	
+	/* Waves started by the last powerUp() */
+	uint8_t getWaves() const
+	{
+		return waves;
+	}
+	
+private:
+	struct Slot
+	{
+		Sequencer sequencer;
+		uint8_t segment;
+		uint32_t inrush;
+		bool queued;   // waiting for inrush budget
+		bool drawing;  // powering up, counted in the fleet's inrush
+	};
+	
+	void begin(Callback callback, void *context)
+	{
+		for (int i = 0; i < devices; i++)
+			slots[i].queued = false;
+		this->callback = callback;
+		this->context = context;
+		pending = 0;
+		failed = 0;
+		waves = 0;
+	}
+	
+	/* Start queued devices while they fit; one alone always fits so nothing waits forever */
+	void wave(uint32_t now)
+	{
+		bool started = false;
+		for (int i = 0; i < devices && pending; i++)
+		{
+			Slot &slot = slots[i];
+			if (!slot.queued || (inrush && inrush + slot.inrush > inrush_limit))
+				continue;
+			enter(slot.segment);
+			slot.queued = false;
+			pending--;
+			inrush += slot.inrush;
+			slot.drawing = true;
+			slot.sequencer.powerUp(now);
+			started = true;
+		}
+		if (started)
+			waves++;
+	}
+	
+	/* Return the inrush share of a device that stopped powering up */
+	void release(Slot &slot)
+	{
+		if (slot.drawing)
+			inrush -= slot.inrush;
+		slot.drawing = false;
+	}
+	
+	/* Run the callback once nothing is running or waiting */
+	void settle()
+	{
+		if (isBusy())
+			return;
+		Callback callback = this->callback;
+		this->callback = 0;
+		if (callback)
+			callback(context, failed);
+	}
+	
+	/* Switch the bus to segment unless it is selected already */
+	void enter(uint8_t segment)
+	{
+		if (selected && this->segment == segment)
+			return;
+		this->segment = segment;
+		selected = true;
+		if (select)
+			select(select_context, segment);
+	}
+	
+	uint32_t inrush_limit;
+	Select select;
+	void *select_context;
+	uint32_t timeout_us;
+	uint32_t poll_us;
+	uint32_t dcdc_us;
+	Callback callback;
+	void *context;
+	Slot slots[MaxDevices];
+	int devices;
+	uint8_t segment;
+	bool selected;
+	int pending;
+	uint32_t inrush;
+	uint8_t failed;
+	uint8_t waves;
+};
+
+#endif
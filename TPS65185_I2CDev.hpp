@@ -0,0 +1,277 @@
+/*
+ * name:        TPS65185
+ * description: Linux i2c-dev transport for the TPS65185
+ * manuf:       Texas Instruments
+ * version:     0.1
+ * url:         http://www.ti.com/lit/ds/symlink/tps65185.pdf
+ * date:        2016-08-01
+ * author       https://chisl.io/
+ * file:        TPS65185_I2CDev.hpp
+ */
+
+#ifndef TPS65185_I2CDEV_HPP
+#define TPS65185_I2CDEV_HPP
+
+#include "TPS65185.hpp"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+
+/*
+ * Register access through /dev/i2c-N with the I2C_RDWR ioctl.
+ * Use TPS65185_Device<TPS65185_I2CDev<> > for static dispatch or TPS65185_I2CDev<TPS65185_Base>
+ * where a TPS65185_Base is required.
+ * Every access is a single syscall: a read is the register address write and the data read
+ * joined by a repeated start, a burst moves any number of consecutive registers.
+ * Between beginBatch() and commitBatch() writes are queued as I2C messages and sent with
+ * one ioctl at commit; a read in between is appended to the queue and sends it at once, so
+ * queued writes are never overtaken. The queue is also sent when it is full.
+ * The ioctl function can be replaced, e.g. by an in-process fake for tests; the real
+ * device, or i2c-stub, needs none.
+ * Failed transfers read as 0 and are counted; errorCount() and lastError() (an errno value)
+ * report them, and transferFailed() tells the core not to shadow a failed read.
+ * A bus opened by open() is closed with the object, so it cannot be copied; construct it
+ * in place, e.g. TPS65185_Device<TPS65185_I2CDev<> > pmic; pmic.open("/dev/i2c-1").
+ */
+template <class Base = TPS65185_NoBase>
+class TPS65185_I2CDev : public Base
+{
+public:
+	typedef int (*Ioctl)(int fd, unsigned long request, void *argument);
+	
+	static const uint16_t __address = 0x68;  // 7 bit I2C address of the TPS65185
+	static const uint8_t __messages = I2C_RDWR_IOCTL_MAX_MSGS;
+	static const uint16_t __buffer = 256;
+	
+	explicit TPS65185_I2CDev(int fd = -1, uint16_t address = __address, Ioctl ioctl = systemIoctl)
+		: fd(fd), owned(false), address(address), ioctl(ioctl), batching(false), messages(0), used(0),
+		  syscalls(0), errors(0), error(0), failed(false)
+	{
+	}
+	
+	~TPS65185_I2CDev()
+	{
+		close();
+	}
+	
+	/* Open a bus such as "/dev/i2c-1"; false with lastError() set when it fails */
+	bool open(const char *path)
+	{
+		close();
+		fd = ::open(path, O_RDWR);
+		if (fd < 0)
+		{
+			fail(errno);
+			return false;
+		}
+		owned = true;
+		return true;
+	}
+	
+	/* Close a bus opened by open(); a file descriptor passed in stays open */
+	void close()
+	{
+		if (owned && fd >= 0)
+			::close(fd);
+		fd = -1;
+		owned = false;
+	}
+	
+	/* Use a bus opened by the caller; it stays open */
+	void attach(int fd, uint16_t address = __address)
+	{
+		close();
+		this->fd = fd;
+		this->address = address;
+	}
+	
+	/* Replace the ioctl function, e.g. by an in-process fake */
+	void setIoctl(Ioctl ioctl)
+	{
+		this->ioctl = ioctl;
+	}
+	
+	int getFd() const
+	{
+		return fd;
+	}
+	
+	/* Transport interface */
+	uint8_t read8(uint16_t address, uint16_t n=8)
+	{
+		(void)n;
+		uint8_t value = 0;
+		read(address, &value, 1);
+		return value;
+	}
+	
+	void write(uint16_t address, uint8_t value, uint16_t n=8)
+	{
+		(void)n;
+		writeBurst(address, &value, 1);
+	}
+	
+	/* 16 bit read, byteorder little */
+	uint16_t read16(uint16_t address, uint16_t n=16)
+	{
+		(void)n;
+		uint8_t data[2] = { 0, 0 };
+		read(address, data, 2);
+		return data[0] | (uint16_t(data[1]) << 8);
+	}
+	
+	/* 16 bit write, byteorder little */
+	void write(uint16_t address, uint16_t value, uint16_t n=16)
+	{
+		(void)n;
+		uint8_t data[2] = { uint8_t(value & 0xff), uint8_t(value >> 8) };
+		writeBurst(address, data, 2);
+	}
+	
+	void readBurst(uint16_t address, uint8_t *data, uint16_t count)
+	{
+		read(address, data, count);
+	}
+	
+	void writeBurst(uint16_t address, const uint8_t *data, uint16_t count)
+	{
+		if (!reserve(2, count + 1))
+			return;
+		uint8_t *buffer = queue(count + 1);
+		buffer[0] = address;
+		for (uint16_t i = 0; i < count; i++)
+			buffer[i + 1] = data[i];
+		if (!batching)
+			transfer();
+	}
+	
+	/* Queue writes until commitBatch() */
+	void beginBatch()
+	{
+		batching = true;
+	}
+	
+	/* Send the queued writes in one ioctl; false when the transfer failed */
+	bool commitBatch()
+	{
+		batching = false;
+		return transfer();
+	}
+	
+	/* Number of ioctl calls made */
+	uint32_t syscallCount() const
+	{
+		return syscalls;
+	}
+	
+	uint32_t errorCount() const
+	{
+		return errors;
+	}
+	
+	int lastError() const
+	{
+		return error;
+	}
+	
+	/* Did the last transfer fail? */
+	bool transferFailed() const
+	{
+		return failed;
+	}
+	
+private:
+	TPS65185_I2CDev(const TPS65185_I2CDev &);
+	TPS65185_I2CDev &operator=(const TPS65185_I2CDev &);
+	
+	static int systemIoctl(int fd, unsigned long request, void *argument)
+	{
+		return ::ioctl(fd, request, argument);
+	}
+	
+	/* Register address write and data read joined by a repeated start */
+	void read(uint16_t address, uint8_t *data, uint16_t count)
+	{
+		for (uint16_t i = 0; i < count; i++)
+			data[i] = 0;
+		if (!reserve(2, 1))
+			return;
+		queue(1)[0] = address;
+		msg[messages].addr = this->address;
+		msg[messages].flags = I2C_M_RD;
+		msg[messages].len = count;
+		msg[messages].buf = data;
+		messages++;
+		transfer();
+	}
+	
+	/* Make room for count messages and size buffer bytes, sending the queue when needed */
+	bool reserve(uint8_t count, uint16_t size)
+	{
+		if (size > __buffer)
+		{
+			fail(EINVAL);
+			return false;
+		}
+		if (messages + count > __messages || used + size > __buffer)
+			transfer();
+		return true;
+	}
+	
+	/* Append a write message of size bytes from the buffer and return its data */
+	uint8_t *queue(uint16_t size)
+	{
+		uint8_t *data = buffer + used;
+		msg[messages].addr = address;
+		msg[messages].flags = 0;
+		msg[messages].len = size;
+		msg[messages].buf = data;
+		messages++;
+		used += size;
+		return data;
+	}
+	
+	bool transfer()
+	{
+		if (!messages)
+			return true;
+		struct i2c_rdwr_ioctl_data data;
+		data.msgs = msg;
+		data.nmsgs = messages;
+		messages = 0;
+		used = 0;
+		syscalls++;
+		failed = false;
+		if (ioctl(fd, I2C_RDWR, &data) >= 0)
+			return true;
+		fail(errno);
+		return false;
+	}
+	
+	void fail(int error)
+	{
+		errors++;
+		this->error = error;
+		failed = true;
+	}
+	
+	int fd;
+	bool owned;
+	uint16_t address;
+	Ioctl ioctl;
+	bool batching;
+	uint8_t messages;
+	uint16_t used;
+	uint32_t syscalls;
+	uint32_t errors;
+	int error;
+	bool failed;
+	struct i2c_msg msg[__messages];
+	uint8_t buffer[__buffer];
+};
+
+#endif
@@ -0,0 +1,156 @@
+/*
+ * name:        TPS65185
+ * description: Interrupt event dispatcher for the TPS65185
+ * manuf:       Texas Instruments
+ * version:     0.1
+ * url:         http://www.ti.com/lit/ds/symlink/tps65185.pdf
+ * date:        2016-08-01
+ * author       https://chisl.io/
+ * file:        TPS65185_Interrupts.hpp
+ */
+
+#ifndef TPS65185_INTERRUPTS_HPP
+#define TPS65185_INTERRUPTS_HPP
+
+#include "TPS65185.hpp"
+
+/*
+ * Dispatches INT1/INT2 events to subscribed handlers. Call onInterrupt() when nINT goes
+ * low: it reads (and thereby clears) INT1 and INT2 in one transfer and calls every handler
+ * subscribed to one of the pending events. INT_EN1/INT_EN2 are programmed from the union of all
+ * subscriptions, so unsubscribed events never assert nINT.
+ * Events are laid out as in TPS65185_Device::Interrupts: INT1 bits in the low byte and INT2 bits
+ * in the high byte, see the constants.
+ */
+template <class Device, int MaxHandlers = 8>
+class TPS65185_Interrupts
+{
+public:
+	typedef void (*Handler)(void *context, uint16_t events);
+	
+	/* INT1 */
+	static const uint16_t DTX = Device::INT1::DTX::mask;
+	static const uint16_t TSD = Device::INT1::TSD::mask;
+	static const uint16_t HOT = Device::INT1::HOT::mask;
+	static const uint16_t TMST_HOT = Device::INT1::TMST_HOT::mask;
+	static const uint16_t TMST_COLD = Device::INT1::TMST_COLD::mask;
+	static const uint16_t UVLO = Device::INT1::UVLO::mask;
+	static const uint16_t ACQC = Device::INT1::ACQC::mask;
+	static const uint16_t PRGC = Device::INT1::PRGC::mask;
+	/* INT2 */
+	static const uint16_t VB_UV = Device::INT2::VB_UV::mask << 8;
+	static const uint16_t VDDH_UV = Device::INT2::VDDH_UV::mask << 8;
+	static const uint16_t VN_UV = Device::INT2::VN_UV::mask << 8;
+	static const uint16_t VPOS_UV = Device::INT2::VPOS_UV::mask << 8;
+	static const uint16_t VEE_UV = Device::INT2::VEE_UV::mask << 8;
+	static const uint16_t VCOMF = Device::INT2::VCOMF::mask << 8;
+	static const uint16_t VNEG_UV = Device::INT2::VNEG_UV::mask << 8;
+	static const uint16_t EOC = Device::INT2::EOC::mask << 8;
+	
+	explicit TPS65185_Interrupts(Device &device)
+		: device(device), handlers(0), enabled(0), programmed(false), dispatching(false)
+	{
+	}
+	
+	/* Call handler for events; returns false when all MaxHandlers slots are taken */
+	bool subscribe(uint16_t events, Handler handler, void *context = 0)
+	{
+		if (handlers == MaxHandlers)
+			return false;
+		slots[handlers].events = events;
+		slots[handlers].handler = handler;
+		slots[handlers].context = context;
+		handlers++;
+		program();
+		return true;
+	}
+	
+	/* Remove all subscriptions of handler with context; safe from within a handler */
+	void unsubscribe(Handler handler, void *context = 0)
+	{
+		for (int i = 0; i < handlers; i++)
+			if (slots[i].handler == handler && slots[i].context == context)
+				slots[i].handler = 0;
+		if (!dispatching)
+			compact();
+	}
+	
+	/* Read and clear INT1/INT2, dispatch; returns the pending events */
+	uint16_t onInterrupt()
+	{
+		uint16_t events = device.getInterrupts().value;
+		dispatch(events);
+		return events;
+	}
+	
+	/*
+	 * Dispatch events read elsewhere, e.g. from a Snapshot. Handlers may subscribe and
+	 * unsubscribe: a removed handler is not called any more, an added one from the next
+	 * dispatch on; the slots are compacted when the dispatch is over.
+	 */
+	void dispatch(uint16_t events)
+	{
+		bool nested = dispatching;
+		dispatching = true;
+		int count = handlers;
+		for (int i = 0; i < count; i++)
+			if (slots[i].handler && (slots[i].events & events))
+				slots[i].handler(slots[i].context, slots[i].events & events);
+		dispatching = nested;
+		if (!dispatching)
+			compact();
+	}
+	
+	/* Events currently enabled in INT_EN1/INT_EN2 */
+	uint16_t enabledEvents() const
+	{
+		return enabled;
+	}
+	
+private:
+	/* Drop the slots of removed handlers */
+	void compact()
+	{
+		int kept = 0;
+		for (int i = 0; i < handlers; i++)
+			if (slots[i].handler)
+				slots[kept++] = slots[i];
+		if (kept == handlers)
+			return;
+		handlers = kept;
+		program();
+	}
+	
+	/* Write INT_EN1/INT_EN2 when the union of subscriptions changed */
+	void program()
+	{
+		uint16_t events = 0;
+		for (int i = 0; i < handlers; i++)
+			if (slots[i].handler)
+				events |= slots[i].events;
+		if (programmed && events == enabled)
+			return;
+		if (!programmed || (events & 0xff) != (enabled & 0xff))
+			device.setINT_EN1(events & 0xff);
+		if (!programmed || (events >> 8) != (enabled >> 8))
+			device.setINT_EN2(events >> 8);
+		enabled = events;
+		programmed = true;
+	}
+	
+	struct Slot
+	{
+		uint16_t events;
+		Handler handler;
+		void *context;
+	};
+	
+	Device &device;
+	Slot slots[MaxHandlers];
+	int handlers;
+	uint16_t enabled;
+	bool programmed;
+	bool dispatching;
+};
+
+#endif
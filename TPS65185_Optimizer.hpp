@@ -0,0 +1,98 @@
+/*
+ * name:        TPS65185
+ * description: Power-up sequence optimizer for the TPS65185
+ * manuf:       Texas Instruments
+ * version:     0.1
+ * url:         http://www.ti.com/lit/ds/symlink/tps65185.pdf
+ * date:        2016-08-01
+ * author       https://chisl.io/
+ * file:        TPS65185_Optimizer.hpp
+ */
+
+#ifndef TPS65185_OPTIMIZER_HPP
+#define TPS65185_OPTIMIZER_HPP
+
+#include "TPS65185_Timing.hpp"
+
+/*
+ * Host-side search for the UPSEQ0/UPSEQ1 values with the shortest power-up sequence that
+ * meets the panel's constraints. All 4^4 strobe assignments and 4^4 UDLY delay codes are
+ * evaluated with TPS65185_Timeline; on equal sequence time the lowest register values win,
+ * so the result is deterministic.
+ */
+class TPS65185_Optimizer
+{
+public:
+	typedef TPS65185_Timeline::Rail Rail;
+	static const int RAILS = TPS65185_Timeline::RAILS;
+	
+	struct Constraints
+	{
+		/* Rails (bit 1 << Rail) that must be on strictly before rail r is switched on */
+		uint8_t after[RAILS];
+		/* Time rail r needs to settle before any later rail is switched on, in us */
+		uint32_t settle_us[RAILS];
+		
+		/* No settling time, VPOS after VNEG (see ENABLE::VPOS_EN) */
+		Constraints()
+		{
+			for (int r = 0; r < RAILS; r++)
+			{
+				after[r] = 0;
+				settle_us[r] = 0;
+			}
+			after[TPS65185_Timeline::VPOS] = 1 << TPS65185_Timeline::VNEG;
+		}
+	};
+	
+	struct Result
+	{
+		bool found;
+		uint8_t upseq0;
+		uint8_t upseq1;
+		TPS65185_Timeline timeline;
+	};
+	
+	static Result solve(const Constraints &constraints)
+	{
+		Result best;
+		best.found = false;
+		best.upseq0 = best.upseq1 = 0;
+		for (unsigned upseq0 = 0; upseq0 < 256; upseq0++)
+		{
+			for (unsigned upseq1 = 0; upseq1 < 256; upseq1++)
+			{
+				TPS65185_Timeline t = TPS65185_Timeline::powerUp(upseq0, upseq1);
+				if (best.found && t.done >= best.timeline.done)
+					continue;
+				if (!satisfies(t, constraints))
+					continue;
+				best.found = true;
+				best.upseq0 = upseq0;
+				best.upseq1 = upseq1;
+				best.timeline = t;
+			}
+		}
+		return best;
+	}
+	
+	/* Does timeline t meet constraints? */
+	static bool satisfies(const TPS65185_Timeline &t, const Constraints &constraints)
+	{
+		for (int r = 0; r < RAILS; r++)
+		{
+			for (int q = 0; q < RAILS; q++)
+			{
+				if (q == r)
+					continue;
+				if ((constraints.after[r] & (1 << q)) && t.rail[q] >= t.rail[r])
+					return false;
+				if (t.rail[r] > t.rail[q] && t.rail[r] - t.rail[q] < constraints.settle_us[q])
+					return false;
+			}
+		}
+		return true;
+	}
+};
+
+#endif
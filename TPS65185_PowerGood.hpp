@@ -0,0 +1,185 @@
+/*
+ * name:        TPS65185
+ * description: Power-good watchdog with adaptive polling for the TPS65185
+ * manuf:       Texas Instruments
+ * version:     0.1
+ * url:         http://www.ti.com/lit/ds/symlink/tps65185.pdf
+ * date:        2016-08-01
+ * author       https://chisl.io/
+ * file:        TPS65185_PowerGood.hpp
+ */
+
+#ifndef TPS65185_POWERGOOD_HPP
+#define TPS65185_POWERGOOD_HPP
+
+#include "TPS65185.hpp"
+#include "TPS65185_Sequencer.hpp"
+
+/*
+ * Watches the PG bits VB_PG, VDDH_PG, VN_PG, VPOS_PG, VEE_PG and VNEG_PG.
+ * tick() reads PG when a poll is due. The poll interval starts at min_us and doubles after
+ * every poll that finds PG unchanged, up to max_us; any change drops it back to min_us.
+ * When INT_EN2 enables the UV interrupt of every rail (the INT2 UV bits match the PG bits),
+ * a rail that drops raises nINT, so polling is not needed for detection: subscribe onUV()
+ * to the INT2 UV events and the next tick() reads PG at once, while polling continues at
+ * max_us only as a heartbeat. start() reads INT_EN2 to choose; call it again after
+ * changing INT_EN2.
+ * The callback runs for every change with the new PG bits and those lost; a rail lost
+ * while the watchdog is armed (the rails are supposed to be up) counts as a fault.
+ * Times are in microseconds from any free-running clock.
+ */
+template <class Device>
+class TPS65185_PowerGood
+{
+public:
+	typedef void (*Callback)(void *context, uint8_t pg, uint8_t lost, uint32_t time);
+	
+	static const uint8_t __rails = TPS65185_Sequencer<Device>::__rails;
+	static const uint8_t __uv = Device::INT_EN2::VBUVEN::mask | Device::INT_EN2::VDDHUVEN::mask
+		| Device::INT_EN2::VNUV_EN::mask | Device::INT_EN2::VPOSUVEN::mask | Device::INT_EN2::VEEUVEN::mask
+		| Device::INT_EN2::VNEGUVEN::mask;
+	
+	explicit TPS65185_PowerGood(Device &device, uint32_t min_us = 1000, uint32_t max_us = 1000000)
+		: device(device), min_us(min_us), max_us(max_us), callback(0), context(0), running(false),
+		  armed(false), interrupt(false), uv(false), pg(0), interval(min_us), next_poll(0), last_fault(0),
+		  fault_count(0), poll_count(0)
+	{
+		for (int i = 0; i < 8; i++)
+			changed_at[i] = 0;
+	}
+	
+	/* Called for every change of the PG bits */
+	void setCallback(Callback callback, void *context = 0)
+	{
+		this->callback = callback;
+		this->context = context;
+	}
+	
+	/* Start watching: reads PG and INT_EN2 */
+	void start(uint32_t now)
+	{
+		running = true;
+		uv = false;
+		interrupt = (device.getINT_EN2() & __uv) == __uv;
+		pg = device.getPG() & __rails;
+		poll_count++;
+		for (int i = 0; i < 8; i++)
+			changed_at[i] = now;
+		interval = interrupt ? max_us : min_us;
+		next_poll = now + interval;
+	}
+	
+	void stop()
+	{
+		running = false;
+	}
+	
+	/* Report lost rails as faults, e.g. while the panel is powered */
+	void arm(bool armed)
+	{
+		this->armed = armed;
+	}
+	
+	/* Read PG if a poll is due or a UV interrupt was signalled */
+	void tick(uint32_t now)
+	{
+		if (!running || (!uv && int32_t(now - next_poll) < 0))
+			return;
+		uv = false;
+		poll(now);
+	}
+	
+	/* Read PG now, e.g. right after a power transition */
+	void poll(uint32_t now)
+	{
+		uint8_t value = device.getPG() & __rails;
+		poll_count++;
+		uint8_t changed = value ^ pg;
+		if (changed)
+		{
+			uint8_t lost = changed & pg;
+			pg = value;
+			for (int i = 0; i < 8; i++)
+				if (changed & (1 << i))
+					changed_at[i] = now;
+			if (lost && armed)
+			{
+				fault_count++;
+				last_fault = now;
+			}
+			interval = interrupt ? max_us : min_us;
+			if (callback)
+				callback(context, value, lost, now);
+		}
+		else if (!interrupt && interval < max_us)
+			interval = interval * 2 < max_us ? interval * 2 : max_us;
+		next_poll = now + interval;
+	}
+	
+	/* Handler for the INT2 UV events, e.g. for TPS65185_Interrupts; polls on the next tick() */
+	static void onUV(void *context, uint16_t events)
+	{
+		(void)events;
+		static_cast<TPS65185_PowerGood *>(context)->uv = true;
+	}
+	
+	/* PG bits of the rails as last read */
+	uint8_t state() const
+	{
+		return pg;
+	}
+	
+	/* Time of the last change of PG bit, e.g. 4 for VPOS_PG */
+	uint32_t lastChange(uint8_t bit) const
+	{
+		return changed_at[bit & 7];
+	}
+	
+	/* Rails lost while armed, and the time of the last such fault */
+	uint32_t faults() const
+	{
+		return fault_count;
+	}
+	
+	uint32_t lastFault() const
+	{
+		return last_fault;
+	}
+	
+	/* Number of PG reads */
+	uint32_t polls() const
+	{
+		return poll_count;
+	}
+	
+	bool isInterruptDriven() const
+	{
+		return interrupt;
+	}
+	
+	/* Time when the next PG read is due */
+	uint32_t nextPoll() const
+	{
+		return next_poll;
+	}
+	
+private:
+	Device &device;
+	uint32_t min_us;
+	uint32_t max_us;
+	Callback callback;
+	void *context;
+	bool running;
+	bool armed;
+	bool interrupt;
+	bool uv;
+	uint8_t pg;
+	uint32_t interval;
+	uint32_t next_poll;
+	uint32_t last_fault;
+	uint32_t fault_count;
+	uint32_t poll_count;
+	uint32_t changed_at[8];
+};
+
+#endif
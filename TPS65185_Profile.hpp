@@ -0,0 +1,177 @@
+/*
+ * name:        TPS65185
+ * description: Configuration profile image of the TPS65185
+ * manuf:       Texas Instruments
+ * version:     0.1
+ * url:         http://www.ti.com/lit/ds/symlink/tps65185.pdf
+ * date:        2016-08-01
+ * author       https://chisl.io/
+ * file:        TPS65185_Profile.hpp
+ */
+
+#ifndef TPS65185_PROFILE_HPP
+#define TPS65185_PROFILE_HPP
+
+#include "TPS65185.hpp"
+#include "TPS65185_Batch.hpp"
+
+/*
+ * Every writable configuration register from VADJ through TMST2, without the read-only
+ * INT1/INT2, as a fixed-layout image of __size bytes:
+ *   0..1   magic "TP"
+ *   2      format version (1)
+ *   3      reserved, 0
+ *   4..14  VADJ, VCOM (low, high), INT_EN1, INT_EN2, UPSEQ0, UPSEQ1, DWNSEQ0, DWNSEQ1,
+ *          TMST1, TMST2
+ *   15..16 CRC-16/CCITT (polynomial 0x1021, initial 0xffff) of bytes 0..14, big endian
+ * Self-clearing bits (VCOM::ACQ/PROG, TMST1::READ_THERM/CONV_END) are always stored as 0.
+ * capture() reads a device with two burst reads around INT1/INT2, apply() writes it with
+ * two burst writes and applyChanges() writes only the registers that differ from the
+ * device, as few bursts as possible.
+ */
+class TPS65185_Profile
+{
+public:
+	typedef TPS65185_Base R;  // register definitions
+	
+	static const uint8_t __version = 1;
+	static const uint8_t __registers = 11;
+	static const uint8_t __size = 4 + __registers + 2;
+	
+	TPS65185_Profile()
+	{
+		for (uint8_t i = 0; i < __registers; i++)
+			regs[i] = 0;
+	}
+	
+	/* Is address one of the registers of a profile? */
+	static bool contains(uint16_t address)
+	{
+		return (address >= R::VADJ::__address && address < R::INT1::__address)
+			|| (address > R::INT2::__address && address <= R::TMST2::__address);
+	}
+	
+	/* Register value in the profile; 0 for registers it does not contain */
+	uint8_t get(uint16_t address) const
+	{
+		return contains(address) ? regs[slot(address)] : 0;
+	}
+	
+	void set(uint16_t address, uint8_t value)
+	{
+		if (contains(address))
+			regs[slot(address)] = value & ~R::volatileMask(address);
+	}
+	
+	/* Write the image to blob, __size bytes */
+	void encode(uint8_t *blob) const
+	{
+		blob[0] = 'T';
+		blob[1] = 'P';
+		blob[2] = __version;
+		blob[3] = 0;
+		for (uint8_t i = 0; i < __registers; i++)
+			blob[4 + i] = regs[i];
+		uint16_t crc = crc16(blob, __size - 2);
+		blob[__size - 2] = crc >> 8;
+		blob[__size - 1] = crc & 0xff;
+	}
+	
+	/* Read the image from blob; false, leaving the profile unchanged, if it is not valid */
+	bool decode(const uint8_t *blob)
+	{
+		if (blob[0] != 'T' || blob[1] != 'P' || blob[2] != __version)
+			return false;
+		if (crc16(blob, __size - 2) != ((uint16_t(blob[__size - 2]) << 8) | blob[__size - 1]))
+			return false;
+		for (uint8_t i = 0; i < __registers; i++)
+			set(address(i), blob[4 + i]);
+		return true;
+	}
+	
+	/* Bit n set for the n-th register (in image order) that differs from other */
+	uint16_t differences(const TPS65185_Profile &other) const
+	{
+		uint16_t mask = 0;
+		for (uint8_t i = 0; i < __registers; i++)
+			if (regs[i] != other.regs[i])
+				mask |= 1 << i;
+		return mask;
+	}
+	
+	/* Read the configuration of device */
+	template <class Device>
+	void capture(Device &device)
+	{
+		uint8_t data[R::__registers];
+		uint16_t first = R::VADJ::__address;
+		uint16_t next = R::INT2::__address + 1;
+		device.readBurst(first, data + first, R::INT1::__address - first);
+		device.readBurst(next, data + next, R::TMST2::__address + 1 - next);
+		for (uint8_t i = 0; i < __registers; i++)
+			set(address(i), data[address(i)]);
+	}
+	
+	/* Write the whole profile to device */
+	template <class Device>
+	void apply(Device &device) const
+	{
+		write(device, (1 << __registers) - 1);
+	}
+	
+	/* Write only the registers that differ from device; returns how many were written */
+	template <class Device>
+	uint8_t applyChanges(Device &device) const
+	{
+		TPS65185_Profile current;
+		current.capture(device);
+		uint16_t mask = differences(current);
+		write(device, mask);
+		uint8_t count = 0;
+		for (; mask; mask &= mask - 1)
+			count++;
+		return count;
+	}
+	
+	/* CRC-16/CCITT of count bytes */
+	static uint16_t crc16(const uint8_t *data, uint16_t count)
+	{
+		uint16_t crc = 0xffff;
+		for (uint16_t i = 0; i < count; i++)
+		{
+			crc ^= uint16_t(data[i]) << 8;
+			for (uint8_t bit = 0; bit < 8; bit++)
+				crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+		}
+		return crc;
+	}
+	
+private:
+	/* Index in the image of a register address, and back */
+	static uint8_t slot(uint16_t address)
+	{
+		return address < R::INT1::__address ? address - R::VADJ::__address
+			: address - R::VADJ::__address - 2;
+	}
+	
+	static uint16_t address(uint8_t slot)
+	{
+		uint16_t address = R::VADJ::__address + slot;
+		return address < R::INT1::__address ? address : address + 2;
+	}
+	
+	/* Write the registers in mask through a batch, so adjacent ones share a burst */
+	template <class Device>
+	void write(Device &device, uint16_t mask) const
+	{
+		TPS65185_Batch<Device> batch(device);
+		for (uint8_t i = 0; i < __registers; i++)
+			if (mask & (1 << i))
+				batch.write(address(i), regs[i]);
+		batch.commit();
+	}
+	
+	uint8_t regs[__registers];
+};
+
+#endif
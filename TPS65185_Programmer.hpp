@@ -0,0 +1,162 @@
+/*
+ * name:        TPS65185
+ * description: Rate-limited VCOM NVM programming for the TPS65185
+ * manuf:       Texas Instruments
+ * version:     0.1
+ * url:         http://www.ti.com/lit/ds/symlink/tps65185.pdf
+ * date:        2016-08-01
+ * author       https://chisl.io/
+ * file:        TPS65185_Programmer.hpp
+ */
+
+#ifndef TPS65185_PROGRAMMER_HPP
+#define TPS65185_PROGRAMMER_HPP
+
+#include "TPS65185.hpp"
+#include "TPS65185_Profile.hpp"
+
+/*
+ * Commits VCOM[8:0] to nonvolatile memory through VCOM::PROG, but only when needed:
+ * - a code equal to the stored one is not programmed again
+ * - programming more often than once per min_interval_us is refused
+ * program() returns at once; programming completes on INT1::PRGC (subscribe onPRGC()) or
+ * when tick() sees PROG cleared. As VCOM::PROG forces the device into STANDBY, the
+ * configuration (a TPS65185_Profile) captured before programming is written back
+ * afterwards, with the new VCOM; ENABLE is left to the power sequencer. After a TIMEOUT
+ * nothing is written, as PROG may still be running: the device stays in STANDBY.
+ * The stored code is known after load(), called right after power-on while VCOM still
+ * holds the NVM value, or after the first successful program(); until then program()
+ * always programs, as the VCOM register may have been changed since power-on.
+ * Times are in microseconds.
+ */
+template <class Device>
+class TPS65185_Programmer
+{
+public:
+	typedef typename Device::VCOM VCOM;
+	
+	enum Result { STARTED, PROGRAMMED, UNCHANGED, RATE_LIMITED, BUSY, TIMEOUT };
+	typedef void (*Callback)(void *context, Result result);
+	
+	explicit TPS65185_Programmer(Device &device, uint32_t min_interval_us = 60000000,
+		uint32_t timeout_us = 100000, uint32_t poll_us = 5000)
+		: device(device), min_interval_us(min_interval_us), timeout_us(timeout_us), poll_us(poll_us),
+		  callback(0), context(0), known(false), stored(0), ever(false), last(0), programming(false),
+		  prgc(false), code(0), deadline(0), next_poll(0)
+	{
+	}
+	
+	/* Take VCOM[8:0] as the value stored in NVM */
+	void load()
+	{
+		stored = device.template get<typename VCOM::VCOM_>();
+		known = true;
+	}
+	
+	/* VCOM[8:0] stored in NVM; only meaningful if isStoredKnown() */
+	uint16_t storedCode() const
+	{
+		return stored;
+	}
+	
+	bool isStoredKnown() const
+	{
+		return known;
+	}
+	
+	/* Start programming code into NVM unless it is stored already */
+	Result program(uint32_t now, uint16_t code, Callback callback = 0, void *context = 0)
+	{
+		code &= VCOM::VCOM_::mask;
+		if (programming)
+			return BUSY;
+		if (known && code == stored)
+			return UNCHANGED;
+		if (ever && now - last < min_interval_us)
+			return RATE_LIMITED;
+		
+		this->code = code;
+		this->callback = callback;
+		this->context = context;
+		programming = true;
+		prgc = false;
+		deadline = now + timeout_us;
+		next_poll = now + poll_us;
+		last = now;
+		ever = true;
+		
+		uint16_t vcom = device.getVCOM() & ~(VCOM::ACQ::mask | VCOM::HiZ::mask);
+		vcom = Device::template insert<typename VCOM::VCOM_>(vcom, code);
+		config.capture(device);
+		config.set(VCOM::__address, uint8_t(vcom & 0xff));
+		config.set(VCOM::__address + 1, uint8_t(vcom >> 8));
+		device.setVCOM(Device::template insert<typename VCOM::PROG>(vcom, 1));
+		return STARTED;
+	}
+	
+	/* Advance programming; polls VCOM::PROG only when PRGC has not been signalled */
+	void tick(uint32_t now)
+	{
+		if (!programming)
+			return;
+		if (prgc)
+			complete(PROGRAMMED);
+		else if (int32_t(now - next_poll) >= 0)
+		{
+			/* PROG is volatile: read it past the shadow cache */
+			if (!(device.read16(VCOM::__address, 16) & VCOM::PROG::mask))
+				complete(PROGRAMMED);
+			else if (int32_t(now - deadline) >= 0)
+				complete(TIMEOUT);
+			else
+				next_poll = now + poll_us;
+		}
+	}
+	
+	/* Handler for INT1::PRGC, e.g. for TPS65185_Interrupts; completes on the next tick() */
+	static void onPRGC(void *context, uint16_t events)
+	{
+		(void)events;
+		static_cast<TPS65185_Programmer *>(context)->prgc = true;
+	}
+	
+	bool isBusy() const
+	{
+		return programming;
+	}
+	
+private:
+	void complete(Result result)
+	{
+		programming = false;
+		prgc = false;
+		if (result == PROGRAMMED)
+		{
+			stored = code;
+			known = true;
+			/* Restore the configuration lost to the implicit STANDBY */
+			config.apply(device);
+		}
+		if (callback)
+			callback(context, result);
+	}
+	
+	Device &device;
+	uint32_t min_interval_us;
+	uint32_t timeout_us;
+	uint32_t poll_us;
+	Callback callback;
+	void *context;
+	bool known;
+	uint16_t stored;
+	bool ever;
+	uint32_t last;
+	bool programming;
+	bool prgc;
+	uint16_t code;
+	uint32_t deadline;
+	uint32_t next_poll;
+	TPS65185_Profile config;
+};
+
+#endif
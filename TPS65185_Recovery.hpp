@@ -0,0 +1,294 @@
+/*
+ * name:        TPS65185
+ * description: Fault recovery for the TPS65185
+ * manuf:       Texas Instruments
+ * version:     0.1
+ * url:         http://www.ti.com/lit/ds/symlink/tps65185.pdf
+ * date:        2016-08-01
+ * author       https://chisl.io/
+ * file:        TPS65185_Recovery.hpp
+ */
+
+#ifndef TPS65185_RECOVERY_HPP
+#define TPS65185_RECOVERY_HPP
+
+#include "TPS65185.hpp"
+#include "TPS65185_Profile.hpp"
+#include "TPS65185_Sequencer.hpp"
+
+/*
+ * Brings the rails back after a fault without blocking.
+ * Faults are classified from INT1/INT2 as laid out by TPS65185_Device::Interrupts. Thermal
+ * shutdown, UVLO, VCOM fault and rail undervoltage turn the rails off; HOT is a warning
+ * and is only counted. Recovery of a shutdown follows the documented order:
+ * 1. ENABLE::STANDBY to leave the fault state
+ * 2. wait the backoff: backoff_us << retry, capped at max_backoff_us, and after a thermal
+ *    shutdown at least cooldown_us
+ * 3. write back the configuration saved by capture() (TPS65185_Profile::apply())
+ * 4. ENABLE::ACTIVE through TPS65185_Sequencer and wait for all rails in regulation
+ * A failed power-up, or a new fault during it, starts over at 1 with the next retry;
+ * after max_retries the engine gives up until reset().
+ * Feed it with onFault() (e.g. subscribed to TPS65185_Interrupts) and advance it with
+ * tick(). Fault counts and recovery times are kept in Metrics.
+ * Times are in microseconds from any free-running clock.
+ */
+template <class Device>
+class TPS65185_Recovery
+{
+public:
+	typedef TPS65185_Sequencer<Device> Sequencer;
+	
+	enum Fault { NONE, HOT, UNDERVOLTAGE, VCOM_FAULT, UVLO, THERMAL_SHUTDOWN, FAULTS };
+	enum State { IDLE, WAITING, POWERING_UP, FAILED };
+	enum Result { RECOVERED, GAVE_UP };
+	typedef void (*Callback)(void *context, Fault fault, Result result);
+	
+	/* INT2 rail undervoltage bits */
+	static const uint8_t __undervoltage = Device::INT2::VB_UV::mask | Device::INT2::VDDH_UV::mask
+		| Device::INT2::VN_UV::mask | Device::INT2::VPOS_UV::mask | Device::INT2::VEE_UV::mask
+		| Device::INT2::VNEG_UV::mask;
+	
+	/* Interrupt events that turn the rails off, laid out as TPS65185_Device::Interrupts */
+	static const uint16_t __shutdown = Device::INT1::TSD::mask | Device::INT1::UVLO::mask
+		| uint16_t(Device::INT2::VCOMF::mask | __undervoltage) << 8;
+	
+	struct Metrics
+	{
+		uint32_t faults[FAULTS];  // per classification
+		uint32_t recoveries;
+		uint32_t retries;
+		uint32_t failures;         // gave up
+		uint32_t last_us;          // time to recover, fault to rails in regulation
+		uint32_t max_us;
+		uint64_t total_us;
+		
+		/* Mean time to recover */
+		uint32_t mean() const
+		{
+			return recoveries ? uint32_t(total_us / recoveries) : 0;
+		}
+	};
+	
+	explicit TPS65185_Recovery(Device &device, uint8_t max_retries = 5, uint32_t backoff_us = 10000,
+		uint32_t max_backoff_us = 1000000, uint32_t cooldown_us = 1000000)
+		: device(device), sequencer(device), max_retries(max_retries), backoff_us(backoff_us),
+		  max_backoff_us(max_backoff_us), cooldown_us(cooldown_us), callback(0), context(0), state(IDLE),
+		  fault(NONE), pending(0), retry(0), since(0), resume(0), captured(false)
+	{
+		resetMetrics();
+	}
+	
+	/* Called when a recovery ends */
+	void setCallback(Callback callback, void *context = 0)
+	{
+		this->callback = callback;
+		this->context = context;
+	}
+	
+	/* Save the configuration registers to restore after a fault */
+	void capture()
+	{
+		config.capture(device);
+		captured = true;
+	}
+	
+	/* Most severe fault among INT1/INT2 events */
+	static Fault classify(uint16_t events)
+	{
+		if (events & Device::INT1::TSD::mask)
+			return THERMAL_SHUTDOWN;
+		if (events & Device::INT1::UVLO::mask)
+			return UVLO;
+		if (events & (uint16_t(Device::INT2::VCOMF::mask) << 8))
+			return VCOM_FAULT;
+		if (events & (uint16_t(__undervoltage) << 8))
+			return UNDERVOLTAGE;
+		if (events & Device::INT1::HOT::mask)
+			return HOT;
+		return NONE;
+	}
+	
+	/* Handler for the fault events, e.g. for TPS65185_Interrupts; handled on the next tick() */
+	static void onFault(void *context, uint16_t events)
+	{
+		TPS65185_Recovery *recovery = static_cast<TPS65185_Recovery *>(context);
+		recovery->pending = recovery->pending | events;
+	}
+	
+	/* Handle pending faults and advance a running recovery */
+	void tick(uint32_t now)
+	{
+		if (pending)
+		{
+			uint16_t events = pending;
+			pending = 0;
+			handle(now, events);
+		}
+		switch (state)
+		{
+			case WAITING:
+				if (int32_t(now - resume) >= 0)
+					restart(now);
+				break;
+			case POWERING_UP:
+				sequencer.tick(now);
+				if (sequencer.getState() == Sequencer::ON)
+					recovered(now);
+				else if (!sequencer.isBusy())
+					retryOrGiveUp(now);
+				break;
+			default:
+				break;
+		}
+	}
+	
+	/* Leave FAILED and clear pending faults; the rails stay as they are */
+	void reset()
+	{
+		state = IDLE;
+		fault = NONE;
+		pending = 0;
+		retry = 0;
+	}
+	
+	void resetMetrics()
+	{
+		for (int i = 0; i < FAULTS; i++)
+			metrics.faults[i] = 0;
+		metrics.recoveries = metrics.retries = metrics.failures = 0;
+		metrics.last_us = metrics.max_us = 0;
+		metrics.total_us = 0;
+	}
+	
+	State getState() const
+	{
+		return state;
+	}
+	
+	/* Fault being recovered from, or the last one */
+	Fault getFault() const
+	{
+		return fault;
+	}
+	
+	bool isBusy() const
+	{
+		return state == WAITING || state == POWERING_UP;
+	}
+	
+	const Metrics &getMetrics() const
+	{
+		return metrics;
+	}
+	
+private:
+	void handle(uint32_t now, uint16_t events)
+	{
+		Fault kind = classify(events);
+		if (kind == NONE)
+			return;
+		metrics.faults[kind]++;
+		if (!(events & __shutdown) || state == FAILED)
+			return;
+		if (!isBusy())
+		{
+			/* A new incident: start timing and counting retries */
+			since = now;
+			retry = 0;
+			fault = kind;
+		}
+		else
+		{
+			if (kind > fault)
+				fault = kind;
+			if (state != POWERING_UP)
+				return;
+			/* A fault during power-up fails this attempt */
+			if (!next(now))
+				return;
+		}
+		standby(now);
+	}
+	
+	/* Step 1 and 2: STANDBY, then wait the backoff */
+	void standby(uint32_t now)
+	{
+		device.template set<typename Device::ENABLE::STANDBY>(1);
+		uint32_t wait = backoff_us << (retry < 16 ? retry : 16);
+		if (wait > max_backoff_us || wait < backoff_us)
+			wait = max_backoff_us;
+		if (fault == THERMAL_SHUTDOWN && wait < cooldown_us)
+			wait = cooldown_us;
+		resume = now + wait;
+		state = WAITING;
+	}
+	
+	/* Step 3 and 4: restore the configuration, then power up */
+	void restart(uint32_t now)
+	{
+		if (captured)
+			config.apply(device);
+		state = POWERING_UP;
+		sequencer.powerUp(now);
+	}
+	
+	/* Count a failed attempt; false when the retries are used up */
+	bool next(uint32_t now)
+	{
+		if (retry >= max_retries)
+		{
+			state = FAILED;
+			metrics.failures++;
+			sequencer.powerDown(now);
+			finish(GAVE_UP);
+			return false;
+		}
+		retry++;
+		metrics.retries++;
+		return true;
+	}
+	
+	void retryOrGiveUp(uint32_t now)
+	{
+		if (next(now))
+			standby(now);
+	}
+	
+	void recovered(uint32_t now)
+	{
+		uint32_t elapsed = now - since;
+		state = IDLE;
+		metrics.recoveries++;
+		metrics.last_us = elapsed;
+		if (elapsed > metrics.max_us)
+			metrics.max_us = elapsed;
+		metrics.total_us += elapsed;
+		finish(RECOVERED);
+	}
+	
+	void finish(Result result)
+	{
+		if (callback)
+			callback(context, fault, result);
+	}
+	
+	Device &device;
+	Sequencer sequencer;
+	uint8_t max_retries;
+	uint32_t backoff_us;
+	uint32_t max_backoff_us;
+	uint32_t cooldown_us;
+	Callback callback;
+	void *context;
+	State state;
+	Fault fault;
+	volatile uint16_t pending;
+	uint8_t retry;
+	uint32_t since;
+	uint32_t resume;
+	bool captured;
+	TPS65185_Profile config;
+	Metrics metrics;
+};
+
+#endif
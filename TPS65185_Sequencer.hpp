@@ -0,0 +1,167 @@
+/*
+ * name:        TPS65185
+ * description: Non-blocking power-up/power-down sequencer for the TPS65185
+ * manuf:       Texas Instruments
+ * version:     0.1
+ * url:         http://www.ti.com/lit/ds/symlink/tps65185.pdf
+ * date:        2016-08-01
+ * author       https://chisl.io/
+ * file:        TPS65185_Sequencer.hpp
+ */
+
+#ifndef TPS65185_SEQUENCER_HPP
+#define TPS65185_SEQUENCER_HPP
+
+#include "TPS65185.hpp"
+#include "TPS65185_Timing.hpp"
+
+/*
+ * Drives ENABLE::ACTIVE/STANDBY without blocking. powerUp()/powerDown() start the
+ * transition and return at once; the sequencer is then advanced by tick(), or by onEdge()
+ * from an nINT or PWRGOOD edge, which reads PG at once. tick() first reads PG when
+ * TPS65185_Timeline predicts the sequence to be complete, then once per poll interval.
+ * The callback runs when all rails are in regulation (power-up), all rails are off
+ * (power-down), the timeout expires or the transition is superseded.
+ * Times are in microseconds from any free-running clock.
+ */
+template <class Device>
+class TPS65185_Sequencer
+{
+public:
+	enum State { OFF, POWERING_UP, ON, POWERING_DOWN };
+	enum Result { SUCCESS, TIMEOUT, ABORTED };
+	typedef void (*Callback)(void *context, Result result);
+	
+	static const uint8_t __rails = Device::PG::VB_PG::mask | Device::PG::VDDH_PG::mask
+		| Device::PG::VN_PG::mask | Device::PG::VPOS_PG::mask | Device::PG::VEE_PG::mask
+		| Device::PG::VNEG_PG::mask;
+	
+	explicit TPS65185_Sequencer(Device &device, uint32_t timeout_us = 500000, uint32_t poll_us = 1000)
+		: device(&device), state(OFF), timeout_us(timeout_us), poll_us(poll_us), dcdc_us(0), callback(0),
+		  context(0), deadline(0), next_poll(0)
+	{
+	}
+	
+	/* Sequencer without a device, e.g. in an array; attach() one before use */
+	TPS65185_Sequencer()
+		: device(0), state(OFF), timeout_us(500000), poll_us(1000), dcdc_us(0), callback(0), context(0),
+		  deadline(0), next_poll(0)
+	{
+	}
+	
+	void attach(Device &device, uint32_t timeout_us = 500000, uint32_t poll_us = 1000)
+	{
+		this->device = &device;
+		this->timeout_us = timeout_us;
+		this->poll_us = poll_us;
+	}
+	
+	Device &getDevice()
+	{
+		return *device;
+	}
+	
+	/* Start the power-up sequence defined by UPSEQ0/UPSEQ1 */
+	void powerUp(uint32_t now, Callback callback = 0, void *context = 0)
+	{
+		start(now, POWERING_UP, callback, context);
+		next_poll = now + TPS65185_Timeline::programmedPowerUp(*device, dcdc_us).done;
+		device->template set<typename Device::ENABLE::ACTIVE>(1);
+	}
+	
+	/* Start the power-down sequence defined by DWNSEQ0/DWNSEQ1 */
+	void powerDown(uint32_t now, Callback callback = 0, void *context = 0)
+	{
+		start(now, POWERING_DOWN, callback, context);
+		next_poll = now + TPS65185_Timeline::programmedPowerDown(*device).done;
+		device->template set<typename Device::ENABLE::STANDBY>(1);
+	}
+	
+	/* Advance the sequencer; reads PG only when a poll is due */
+	void tick(uint32_t now)
+	{
+		if (isBusy() && int32_t(now - next_poll) >= 0)
+			check(now);
+	}
+	
+	/* Advance the sequencer after an nINT or PWRGOOD edge */
+	void onEdge(uint32_t now)
+	{
+		if (isBusy())
+			check(now);
+	}
+	
+	/* DC-DC soft-start time of the board, added to the predicted power-up time */
+	void setSoftStart(uint32_t dcdc_us)
+	{
+		this->dcdc_us = dcdc_us;
+	}
+	
+	/* Do not read PG before time */
+	void deferPoll(uint32_t time)
+	{
+		next_poll = time;
+	}
+	
+	State getState() const
+	{
+		return state;
+	}
+	
+	bool isBusy() const
+	{
+		return state == POWERING_UP || state == POWERING_DOWN;
+	}
+	
+	/* Time when the next PG read is due */
+	uint32_t nextPoll() const
+	{
+		return next_poll;
+	}
+	
+private:
+	void start(uint32_t now, State target, Callback callback, void *context)
+	{
+		if (isBusy())
+			finish(state == POWERING_UP ? OFF : ON, ABORTED);
+		state = target;
+		this->callback = callback;
+		this->context = context;
+		deadline = now + timeout_us;
+		next_poll = now + poll_us;
+	}
+	
+	void check(uint32_t now)
+	{
+		uint8_t pg = device->getPG() & __rails;
+		if (state == POWERING_UP && pg == __rails)
+			finish(ON, SUCCESS);
+		else if (state == POWERING_DOWN && pg == 0)
+			finish(OFF, SUCCESS);
+		else if (int32_t(now - deadline) >= 0)
+			finish(state == POWERING_UP ? OFF : ON, TIMEOUT);
+		else
+			next_poll = now + poll_us;
+	}
+	
+	void finish(State settled, Result result)
+	{
+		Callback callback = this->callback;
+		state = settled;
+		this->callback = 0;
+		if (callback)
+			callback(context, result);
+	}
+	
+	Device *device;
+	State state;
+	uint32_t timeout_us;
+	uint32_t poll_us;
+	uint32_t dcdc_us;
+	Callback callback;
+	void *context;
+	uint32_t deadline;
+	uint32_t next_poll;
+};
+
+#endif
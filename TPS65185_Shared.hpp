@@ -0,0 +1,428 @@
+/*
+ * name:        TPS65185
+ * description: Thread-safe front end of the TPS65185
+ * manuf:       Texas Instruments
+ * version:     0.1
+ * url:         http://www.ti.com/lit/ds/symlink/tps65185.pdf
+ * date:        2016-08-01
+ * author       https://chisl.io/
+ * file:        TPS65185_Shared.hpp
+ */
+
+#ifndef TPS65185_SHARED_HPP
+#define TPS65185_SHARED_HPP
+
+#include "TPS65185.hpp"
+
+#include <pthread.h>
+
+/* Lock policy for a single thread */
+class TPS65185_NoLock
+{
+public:
+	void lock() {}
+	void unlock() {}
+};
+
+/* Lock policy using a POSIX mutex; on an RTOS supply a class with the same two functions */
+class TPS65185_PthreadLock
+{
+public:
+	TPS65185_PthreadLock()
+	{
+		pthread_mutex_init(&mutex, 0);
+	}
+	
+	~TPS65185_PthreadLock()
+	{
+		pthread_mutex_destroy(&mutex);
+	}
+	
+	void lock()
+	{
+		pthread_mutex_lock(&mutex);
+	}
+	
+	void unlock()
+	{
+		pthread_mutex_unlock(&mutex);
+	}
+	
+private:
+	TPS65185_PthreadLock(const TPS65185_PthreadLock &);
+	TPS65185_PthreadLock &operator=(const TPS65185_PthreadLock &);
+	
+	pthread_mutex_t mutex;
+};
+
+/*
+ * Shares one device between threads.
+ * TPS65185_Shared offers the interface of Device itself: the register definitions, the
+ * transport functions, the shadow cache, get<F>()/set<F>() and every getXXX()/setXXX().
+ * Components templated over a device, e.g. TPS65185_Sequencer<TPS65185_Shared<Device> >,
+ * TPS65185_Temperature or TPS65185_Calibration, therefore run on it unchanged, one per
+ * thread. Every call holds the bus lock for one bus operation only, so a display thread,
+ * a thermal monitor and a calibration tool interleave at transaction granularity and none
+ * blocks the others for a whole power sequence. set<F>() is a single locked
+ * read-modify-write, so it cannot race with another thread's write of the same register,
+ * and the shadow cache of Device is only used with the lock held.
+ * Where a few operations must not be interleaved, an Access object holds the lock for its
+ * lifetime and hands out the device; keep such sections short.
+ *
+ * Every register value seen on the bus is published to an Image that view() copies
+ * without taking the lock (a sequence counter detects a concurrent update and retries),
+ * so readers of state such as TMST_VALUE or PG never wait for the bus. refresh() updates
+ * the whole image with two bursts that skip INT1/INT2, as reading those clears them.
+ * Published values are as last seen: self-clearing bits are not tracked after a write.
+ * Device accessed through an Access object is not published.
+ */
+template <class Device, class Lock = TPS65185_PthreadLock>
+class TPS65185_Shared
+{
+public:
+	/* Register definitions of Device */
+	typedef typename Device::TMST_VALUE TMST_VALUE;
+	typedef typename Device::ENABLE ENABLE;
+	typedef typename Device::VADJ VADJ;
+	typedef typename Device::VCOM VCOM;
+	typedef typename Device::INT_EN1 INT_EN1;
+	typedef typename Device::INT_EN2 INT_EN2;
+	typedef typename Device::INT1 INT1;
+	typedef typename Device::INT2 INT2;
+	typedef typename Device::UPSEQ0 UPSEQ0;
+	typedef typename Device::UPSEQ1 UPSEQ1;
+	typedef typename Device::DWNSEQ0 DWNSEQ0;
+	typedef typename Device::DWNSEQ1 DWNSEQ1;
+	typedef typename Device::TMST1 TMST1;
+	typedef typename Device::TMST2 TMST2;
+	typedef typename Device::PG PG;
+	typedef typename Device::REVID REVID;
+	typedef typename Device::Interrupts Interrupts;
+	typedef typename Device::Snapshot Snapshot;
+	
+	static const uint16_t __registers = Device::__registers;
+	
+	/* Register values last seen on the bus; bit n of valid is set once register n was seen */
+	struct Image
+	{
+		uint8_t regs[__registers];
+		uint32_t valid;
+		uint32_t generation;  // number of updates
+	};
+	
+	/* Exclusive access to the device for a multi-step operation */
+	class Access
+	{
+	public:
+		explicit Access(TPS65185_Shared &shared) : shared(shared)
+		{
+			shared.lock.lock();
+		}
+		
+		~Access()
+		{
+			shared.lock.unlock();
+		}
+		
+		Device &device()
+		{
+			return shared.device;
+		}
+	
+	private:
+		Access(const Access &);
+		Access &operator=(const Access &);
+		
+		TPS65185_Shared &shared;
+	};
+	
+	explicit TPS65185_Shared(Device &device) : device(device), sequence(0), valid(0), generation(0)
+	{
+		for (uint16_t i = 0; i < __registers; i++)
+			regs[i] = 0;
+	}
+	
+	static uint8_t volatileMask(uint16_t address)
+	{
+		return Device::volatileMask(address);
+	}
+	
+	template <class F>
+	static typename TPS65185_Field<F>::type extract(typename TPS65185_Field<F>::type reg)
+	{
+		return Device::template extract<F>(reg);
+	}
+	
+	template <class F>
+	static typename TPS65185_Field<F>::type insert(typename TPS65185_Field<F>::type reg,
+		typename TPS65185_Field<F>::type value)
+	{
+		return Device::template insert<F>(reg, value);
+	}
+	
+	/* Transport interface: bus access past the shadow cache, as Device */
+	uint8_t read8(uint16_t address, uint16_t n=8)
+	{
+		Access access(*this);
+		uint8_t value = device.read8(address, n);
+		publish(address, &value, 1);
+		return value;
+	}
+	
+	void write(uint16_t address, uint8_t value, uint16_t n=8)
+	{
+		Access access(*this);
+		device.write(address, value, n);
+		publish(address, &value, 1);
+	}
+	
+	uint16_t read16(uint16_t address, uint16_t n=16)
+	{
+		Access access(*this);
+		uint16_t value = device.read16(address, n);
+		publish16(address, value);
+		return value;
+	}
+	
+	void write(uint16_t address, uint16_t value, uint16_t n=16)
+	{
+		Access access(*this);
+		device.write(address, value, n);
+		publish16(address, value);
+	}
+	
+	void readBurst(uint16_t address, uint8_t *data, uint16_t count)
+	{
+		Access access(*this);
+		device.readBurst(address, data, count);
+		publish(address, data, count);
+	}
+	
+	void writeBurst(uint16_t address, const uint8_t *data, uint16_t count)
+	{
+		Access access(*this);
+		device.writeBurst(address, data, count);
+		publish(address, data, count);
+	}
+	
+	/* Shadow cache of Device */
+	void setCacheEnabled(bool enabled)
+	{
+		Access access(*this);
+		device.setCacheEnabled(enabled);
+	}
+	
+	bool isCacheEnabled()
+	{
+		Access access(*this);
+		return device.isCacheEnabled();
+	}
+	
+	void invalidateCache()
+	{
+		Access access(*this);
+		device.invalidateCache();
+	}
+	
+	uint8_t cachedRead8(uint16_t address, uint16_t n=8)
+	{
+		Access access(*this);
+		uint8_t value = device.cachedRead8(address, n);
+		publish(address, &value, 1);
+		return value;
+	}
+	
+	void cachedWrite(uint16_t address, uint8_t value, uint16_t n=8)
+	{
+		Access access(*this);
+		device.cachedWrite(address, value, n);
+		publish(address, &value, 1);
+	}
+	
+	uint16_t cachedRead16(uint16_t address, uint16_t n=16)
+	{
+		Access access(*this);
+		uint16_t value = device.cachedRead16(address, n);
+		publish16(address, value);
+		return value;
+	}
+	
+	void cachedWrite(uint16_t address, uint16_t value, uint16_t n=16)
+	{
+		Access access(*this);
+		device.cachedWrite(address, value, n);
+		publish16(address, value);
+	}
+	
+	void cachedWriteBurst(uint16_t address, const uint8_t *data, uint16_t count)
+	{
+		Access access(*this);
+		device.cachedWriteBurst(address, data, count);
+		publish(address, data, count);
+	}
+	
+	template <class F>
+	typename TPS65185_Field<F>::type get()
+	{
+		Access access(*this);
+		typename TPS65185_Field<F>::type reg = device.template getRegister<F>();
+		publishWord(F::__address, reg);
+		return Device::template extract<F>(reg);
+	}
+	
+	/* Atomic read-modify-write of bit field F */
+	template <class F>
+	void set(typename TPS65185_Field<F>::type value)
+	{
+		Access access(*this);
+		publishWord(F::__address, device.template set<F>(value));
+	}
+	
+	/* Read all registers in one burst, as Device; reading INT1 and INT2 clears them */
+	void readSnapshot(Snapshot &snapshot)
+	{
+		Access access(*this);
+		device.readSnapshot(snapshot);
+		uint8_t data[__registers];
+		data[TMST_VALUE::__address] = snapshot.tmst_value;
+		data[ENABLE::__address] = snapshot.enable;
+		data[VADJ::__address] = snapshot.vadj;
+		data[VCOM::__address] = snapshot.vcom & 0xff;
+		data[VCOM::__address + 1] = snapshot.vcom >> 8;
+		data[INT_EN1::__address] = snapshot.int_en1;
+		data[INT_EN2::__address] = snapshot.int_en2;
+		data[INT1::__address] = snapshot.int1;
+		data[INT2::__address] = snapshot.int2;
+		data[UPSEQ0::__address] = snapshot.upseq0;
+		data[UPSEQ1::__address] = snapshot.upseq1;
+		data[DWNSEQ0::__address] = snapshot.dwnseq0;
+		data[DWNSEQ1::__address] = snapshot.dwnseq1;
+		data[TMST1::__address] = snapshot.tmst1;
+		data[TMST2::__address] = snapshot.tmst2;
+		data[PG::__address] = snapshot.pg;
+		data[REVID::__address] = snapshot.revid;
+		publish(0, data, __registers);
+	}
+	
+	/* Read and clear INT1/INT2 in one transfer */
+	Interrupts getInterrupts()
+	{
+		Access access(*this);
+		Interrupts interrupts = device.getInterrupts();
+		publish16(INT1::__address, interrupts.value);
+		return interrupts;
+	}
+	
+	/* Register accessors of Device, each a single locked call of the Device accessor */
+#define TPS65185_SHARED_REGISTER(R, type) \
+	void set##R(type value) \
+	{ \
+		Access access(*this); \
+		device.set##R(value); \
+		publishWord(R::__address, value); \
+	} \
+	\
+	type get##R() \
+	{ \
+		Access access(*this); \
+		type value = device.get##R(); \
+		publishWord(R::__address, value); \
+		return value; \
+	}
+	
+	TPS65185_SHARED_REGISTER(TMST_VALUE, uint8_t)
+	TPS65185_SHARED_REGISTER(ENABLE, uint8_t)
+	TPS65185_SHARED_REGISTER(VADJ, uint8_t)
+	TPS65185_SHARED_REGISTER(VCOM, uint16_t)
+	TPS65185_SHARED_REGISTER(INT_EN1, uint8_t)
+	TPS65185_SHARED_REGISTER(INT_EN2, uint8_t)
+	TPS65185_SHARED_REGISTER(INT1, uint8_t)
+	TPS65185_SHARED_REGISTER(INT2, uint8_t)
+	TPS65185_SHARED_REGISTER(UPSEQ0, uint8_t)
+	TPS65185_SHARED_REGISTER(UPSEQ1, uint8_t)
+	TPS65185_SHARED_REGISTER(DWNSEQ0, uint8_t)
+	TPS65185_SHARED_REGISTER(DWNSEQ1, uint8_t)
+	TPS65185_SHARED_REGISTER(TMST1, uint8_t)
+	TPS65185_SHARED_REGISTER(TMST2, uint8_t)
+	TPS65185_SHARED_REGISTER(PG, uint8_t)
+	TPS65185_SHARED_REGISTER(REVID, uint8_t)
+
+#undef TPS65185_SHARED_REGISTER
+	
+	/* Read every register except INT1/INT2 and publish them */
+	void refresh()
+	{
+		static const uint16_t int1 = INT1::__address;
+		static const uint16_t next = INT2::__address + 1;
+		uint8_t data[__registers];
+		Access access(*this);
+		device.readBurst(0, data, int1);
+		device.readBurst(next, data + next, __registers - next);
+		publish(0, data, int1);
+		publish(next, data + next, __registers - next);
+	}
+	
+	/* Copy the published image; never waits for the bus lock */
+	void view(Image &image) const
+	{
+		for (;;)
+		{
+			uint32_t before = sequence;
+			__sync_synchronize();
+			if (!(before & 1))
+			{
+				for (uint16_t i = 0; i < __registers; i++)
+					image.regs[i] = regs[i];
+				image.valid = valid;
+				image.generation = generation;
+				__sync_synchronize();
+				if (sequence == before)
+					return;
+			}
+		}
+	}
+	
+private:
+	TPS65185_Shared(const TPS65185_Shared &);
+	TPS65185_Shared &operator=(const TPS65185_Shared &);
+	
+	void publish16(uint16_t address, uint16_t value)
+	{
+		uint8_t data[2] = { uint8_t(value & 0xff), uint8_t(value >> 8) };
+		publish(address, data, 2);
+	}
+	
+	void publishWord(uint16_t address, uint8_t value)
+	{
+		publish(address, &value, 1);
+	}
+	
+	void publishWord(uint16_t address, uint16_t value)
+	{
+		publish16(address, value);
+	}
+	
+	/* Update the image; called with the bus lock held, so there is a single writer */
+	void publish(uint16_t address, const uint8_t *data, uint16_t count)
+	{
+		sequence = sequence + 1;
+		__sync_synchronize();
+		for (uint16_t i = 0; i < count && address + i < __registers; i++)
+		{
+			regs[address + i] = data[i];
+			valid = valid | (1UL << (address + i));
+		}
+		generation = generation + 1;
+		__sync_synchronize();
+		sequence = sequence + 1;
+	}
+	
+	Device &device;
+	Lock lock;
+	volatile uint32_t sequence;  // odd while the image is updated
+	volatile uint8_t regs[__registers];
+	volatile uint32_t valid;
+	volatile uint32_t generation;
+};
+
+#endif
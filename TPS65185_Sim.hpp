@@ -0,0 +1,508 @@
+/*
+ * name:        TPS65185
+ * description: Register-level simulator of the TPS65185 for host-side testing and benchmarking
+ * manuf:       Texas Instruments
+ * version:     0.1
+ * url:         http://www.ti.com/lit/ds/symlink/tps65185.pdf
+ * date:        2016-08-01
+ * author       https://chisl.io/
+ * file:        TPS65185_Sim.hpp
+ */
+
+#ifndef TPS65185_SIM_HPP
+#define TPS65185_SIM_HPP
+
+#include "TPS65185.hpp"
+#include "TPS65185_Timing.hpp"
+#include "TPS65185_Units.hpp"
+
+/*
+ * Deterministic register-level model of the TPS65185.
+ * Use TPS65185_Device<TPS65185_Sim<> > for static dispatch or TPS65185_Sim<TPS65185_Base> where a
+ * TPS65185_Base is required. Time only moves with advance(), so runs are reproducible.
+ *
+ * Modelled behavior:
+ * - ENABLE::ACTIVE powers the rails up along UPSEQ0/UPSEQ1: VB_PG and VN_PG at once, then
+ *   each rail's PG bit at its strobe as predicted by TPS65185_Timeline.
+ *   ENABLE::STANDBY powers them down along DWNSEQ0/DWNSEQ1 and has priority over ACTIVE.
+ *   Both bits clear once the transition is complete.
+ * - Outside a sequence, a write that changes the ENABLE rail bits switches the rails to
+ *   match them; other ENABLE writes (e.g. VCOM_EN) leave the rails as they are.
+ * - VPOS is never up while VNEG is down, in the sequencer as well as with ENABLE::VPOS_EN.
+ * - TMST1::READ_THERM clears CONV_END, and after __conversion_us loads TMST_VALUE, sets
+ *   CONV_END and INT2::EOC and evaluates the DTX, TMST_HOT and TMST_COLD interrupts.
+ * - VCOM::ACQ loads the kick-back code into VCOM[8:0] and sets INT1::ACQC after
+ *   __acquisition_us per averaged sample.
+ * - VCOM::PROG stores VCOM[8:0] to NVM after __programming_us, sets INT1::PRGC and enters
+ *   STANDBY.
+ * - INT1 and INT2 are cleared on read; faults (TSD, UVLO, INT2 UV and VCOMF) power all rails
+ *   off immediately.
+ * Rail ramp times are not modelled: a rail is in regulation the moment its strobe fires.
+ */
+template <class Base = TPS65185_NoBase>
+class TPS65185_Sim : public Base
+{
+public:
+	typedef TPS65185_Base R;  // register definitions
+	
+	static const uint32_t __conversion_us = 1000;
+	static const uint32_t __acquisition_us = 2000;
+	static const uint32_t __programming_us = 10000;
+	
+	TPS65185_Sim() : time(0), temperature(25), kickback(VCOM_dflt), nvm_vcom(VCOM_dflt),
+		transactions(0), nvm_writes(0)
+	{
+		reset();
+	}
+	
+	/* Power-on reset: registers to their defaults, VCOM from NVM, all rails off */
+	void reset()
+	{
+		regs[R::TMST_VALUE::__address] = 0;
+		regs[R::ENABLE::__address] = 0x00;
+		regs[R::VADJ::__address] = (R::VADJ::unused_0::dflt << 3) | R::VADJ::VSET::dflt;
+		regs[R::VCOM::__address] = nvm_vcom & 0xff;
+		regs[R::VCOM::__address + 1] = (R::VCOM::unused_0::dflt << 1) | (nvm_vcom >> 8);
+		regs[R::INT_EN1::__address] = 0x7f;
+		regs[R::INT_EN2::__address] = 0xff;
+		regs[R::INT1::__address] = 0x00;
+		regs[R::INT2::__address] = 0x00;
+		regs[R::UPSEQ0::__address] = 0xe4;
+		regs[R::UPSEQ1::__address] = 0x55;
+		regs[R::DWNSEQ0::__address] = 0x1e;
+		regs[R::DWNSEQ1::__address] = 0xe0;
+		regs[R::TMST1::__address] = R::TMST1::CONV_END::mask;
+		regs[R::TMST2::__address] = (R::TMST2::TMST_COLD::dflt << 4) | R::TMST2::TMST_HOT::dflt;
+		regs[R::PG::__address] = 0x00;
+		regs[R::REVID::__address] = 0x45;
+		sequence = IDLE;
+		converting = acquiring = programming = false;
+		baseline = temperature;
+	}
+	
+	/* Transport interface */
+	uint8_t read8(uint16_t address, uint16_t n=8)
+	{
+		(void)n;
+		transactions++;
+		return readRegister(address);
+	}
+	
+	void write(uint16_t address, uint8_t value, uint16_t n=8)
+	{
+		(void)n;
+		transactions++;
+		writeRegister(address, value);
+	}
+	
+	uint16_t read16(uint16_t address, uint16_t n=16)
+	{
+		(void)n;
+		transactions++;
+		uint8_t lo = readRegister(address);
+		return lo | (uint16_t(readRegister(address + 1)) << 8);
+	}
+	
+	void write(uint16_t address, uint16_t value, uint16_t n=16)
+	{
+		(void)n;
+		transactions++;
+		writeRegister(address, value & 0xff);
+		writeRegister(address + 1, value >> 8);
+	}
+	
+	void readBurst(uint16_t address, uint8_t *data, uint16_t count)
+	{
+		transactions++;
+		for (uint16_t i = 0; i < count; i++)
+			data[i] = readRegister(address + i);
+	}
+	
+	void writeBurst(uint16_t address, const uint8_t *data, uint16_t count)
+	{
+		transactions++;
+		for (uint16_t i = 0; i < count; i++)
+			writeRegister(address + i, data[i]);
+	}
+	
+	/* Move simulated time forward and run everything that completes until then */
+	void advance(uint32_t us)
+	{
+		uint32_t end = time + us;
+		for (;;)
+		{
+			uint32_t next = 0;
+			if (!nextEvent(next) || int32_t(next - end) > 0)
+				break;
+			time = next;
+			process();
+		}
+		time = end;
+		process();
+	}
+	
+	/* Simulated time in microseconds since construction */
+	uint32_t now() const
+	{
+		return time;
+	}
+	
+	/* Level of the (active low) nINT pin: an enabled interrupt is pending */
+	bool interruptPending() const
+	{
+		return (regs[R::INT1::__address] & regs[R::INT_EN1::__address])
+			|| (regs[R::INT2::__address] & regs[R::INT_EN2::__address]);
+	}
+	
+	/* Level of the PWRGOOD pin: all rails in regulation */
+	bool powerGood() const
+	{
+		return regs[R::PG::__address] == allRails;
+	}
+	
+	/* Panel temperature in C, picked up by the next conversion */
+	void setTemperature(int temperature)
+	{
+		this->temperature = temperature;
+	}
+	
+	/* Kick-back voltage code returned by the next VCOM acquisition */
+	void setKickback(uint16_t code)
+	{
+		kickback = code & R::VCOM::VCOM_::mask;
+	}
+	
+	/* Raise interrupt bits as the device would on a fault */
+	void injectInterrupt(uint8_t int1, uint8_t int2)
+	{
+		regs[R::INT1::__address] |= int1;
+		regs[R::INT2::__address] |= int2;
+		if ((int1 & (R::INT1::TSD::mask | R::INT1::UVLO::mask)) || (int2 & ~(R::INT2::EOC::mask)))
+			shutdown();
+	}
+	
+	/* VCOM[8:0] stored in NVM */
+	uint16_t nvmVCOM() const
+	{
+		return nvm_vcom;
+	}
+	
+	/* Number of NVM programming cycles */
+	uint32_t nvmWrites() const
+	{
+		return nvm_writes;
+	}
+	
+	/* Number of bus transactions served */
+	uint32_t busTransactions() const
+	{
+		return transactions;
+	}
+	
+	/* Raw register value without side effects */
+	uint8_t peek(uint16_t address) const
+	{
+		return address < R::__registers ? regs[address] : 0;
+	}
+	
+private:
+	enum Sequence { IDLE, POWER_UP, POWER_DOWN };
+	
+	static const uint16_t VCOM_dflt = R::VCOM::VCOM_::dflt;
+	static const uint8_t allRails = R::PG::VB_PG::mask | R::PG::VDDH_PG::mask | R::PG::VN_PG::mask
+		| R::PG::VPOS_PG::mask | R::PG::VEE_PG::mask | R::PG::VNEG_PG::mask;
+	static const uint8_t strobeRails = R::PG::VDDH_PG::mask | R::PG::VPOS_PG::mask
+		| R::PG::VEE_PG::mask | R::PG::VNEG_PG::mask;
+	static const uint8_t railEnables = R::ENABLE::VDDH_EN::mask | R::ENABLE::VPOS_EN::mask
+		| R::ENABLE::VEE_EN::mask | R::ENABLE::VNEG_EN::mask;
+	
+	uint8_t readRegister(uint16_t address)
+	{
+		if (address >= R::__registers)
+			return 0;
+		uint8_t value = regs[address];
+		if (address == R::INT1::__address || address == R::INT2::__address)
+			regs[address] = 0;
+		return value;
+	}
+	
+	void writeRegister(uint16_t address, uint8_t value)
+	{
+		switch (address)
+		{
+			case R::ENABLE::__address:
+				writeENABLE(value);
+				break;
+			case R::VADJ::__address:
+			case R::VCOM::__address:
+			case R::INT_EN1::__address:
+			case R::INT_EN2::__address:
+			case R::UPSEQ0::__address:
+			case R::UPSEQ1::__address:
+			case R::DWNSEQ0::__address:
+			case R::DWNSEQ1::__address:
+			case R::TMST2::__address:
+				regs[address] = value;
+				break;
+			case R::VCOM::__address + 1:
+				writeVCOM2(value);
+				break;
+			case R::TMST1::__address:
+				writeTMST1(value);
+				break;
+			default:  // TMST_VALUE, INT1, INT2, PG and REVID are read-only
+				break;
+		}
+	}
+	
+	void writeENABLE(uint8_t value)
+	{
+		const uint8_t transition = R::ENABLE::ACTIVE::mask | R::ENABLE::STANDBY::mask;
+		uint8_t &enable = regs[R::ENABLE::__address];
+		uint8_t previous = enable;
+		enable = (enable & transition) | (value & ~transition);
+		
+		/* VPOS cannot be enabled before VNEG, disabling VNEG disables VPOS */
+		if (!(enable & R::ENABLE::VNEG_EN::mask))
+			enable &= ~R::ENABLE::VPOS_EN::mask;
+		
+		/* Rails follow the enable bits only when a write changes them */
+		if (value & R::ENABLE::STANDBY::mask)
+			startPowerDown(time);
+		else if (value & R::ENABLE::ACTIVE::mask)
+			startPowerUp(time);
+		else if (sequence == IDLE && ((previous ^ enable) & railEnables))
+			applyRailEnables();
+	}
+	
+	/* Manual rail control through the ENABLE rail bits */
+	void applyRailEnables()
+	{
+		uint8_t enable = regs[R::ENABLE::__address];
+		uint8_t &pg = regs[R::PG::__address];
+		setRail(pg, R::PG::VDDH_PG::mask, enable & R::ENABLE::VDDH_EN::mask);
+		setRail(pg, R::PG::VEE_PG::mask, enable & R::ENABLE::VEE_EN::mask);
+		setRail(pg, R::PG::VNEG_PG::mask, enable & R::ENABLE::VNEG_EN::mask);
+		setRail(pg, R::PG::VPOS_PG::mask, enable & R::ENABLE::VPOS_EN::mask);
+		if (pg & strobeRails)
+			pg |= R::PG::VB_PG::mask | R::PG::VN_PG::mask;
+		else
+			pg &= ~(R::PG::VB_PG::mask | R::PG::VN_PG::mask);
+	}
+	
+	static void setRail(uint8_t &pg, uint8_t mask, bool on)
+	{
+		pg = on ? (pg | mask) : (pg & ~mask);
+	}
+	
+	void writeVCOM2(uint8_t value)
+	{
+		const uint8_t acq = R::VCOM::ACQ::mask >> 8;
+		const uint8_t prog = R::VCOM::PROG::mask >> 8;
+		uint8_t &vcom2 = regs[R::VCOM::__address + 1];
+		vcom2 = (vcom2 & (acq | prog)) | (value & ~(acq | prog));
+		if ((value & acq) && !acquiring)
+		{
+			vcom2 |= acq;
+			acquiring = true;
+			uint32_t samples = 1 << TPS65185_Base::extract<R::VCOM::AVG>(uint16_t(vcom2) << 8);
+			acquisition_end = time + samples * __acquisition_us;
+		}
+		if ((value & prog) && !programming)
+		{
+			vcom2 |= prog;
+			programming = true;
+			programming_end = time + __programming_us;
+		}
+	}
+	
+	void writeTMST1(uint8_t value)
+	{
+		const uint8_t status = R::TMST1::READ_THERM::mask | R::TMST1::CONV_END::mask;
+		uint8_t &tmst1 = regs[R::TMST1::__address];
+		tmst1 = (tmst1 & status) | (value & ~status);
+		if ((value & R::TMST1::READ_THERM::mask) && !converting)
+		{
+			tmst1 = (tmst1 | R::TMST1::READ_THERM::mask) & ~R::TMST1::CONV_END::mask;
+			converting = true;
+			conversion_end = time + __conversion_us;
+		}
+	}
+	
+	void startPowerUp(uint32_t start)
+	{
+		if (sequence == POWER_UP)
+			return;
+		TPS65185_Timeline t = TPS65185_Timeline::powerUp(regs[R::UPSEQ0::__address],
+			regs[R::UPSEQ1::__address]);
+		for (int rail = 0; rail < RAILS; rail++)
+			rail_time[rail] = start + t.rail[rail];
+		regs[R::ENABLE::__address] = (regs[R::ENABLE::__address] & ~R::ENABLE::STANDBY::mask)
+			| R::ENABLE::ACTIVE::mask;
+		regs[R::PG::__address] |= R::PG::VB_PG::mask | R::PG::VN_PG::mask;
+		sequence = POWER_UP;
+		process();
+	}
+	
+	void startPowerDown(uint32_t start)
+	{
+		if (sequence == POWER_DOWN)
+			return;
+		TPS65185_Timeline t = TPS65185_Timeline::powerDown(regs[R::DWNSEQ0::__address],
+			regs[R::DWNSEQ1::__address]);
+		for (int rail = 0; rail < RAILS; rail++)
+			rail_time[rail] = start + t.rail[rail];
+		down_end = start + t.done;
+		regs[R::ENABLE::__address] = (regs[R::ENABLE::__address] & ~R::ENABLE::ACTIVE::mask)
+			| R::ENABLE::STANDBY::mask;
+		sequence = POWER_DOWN;
+		process();
+	}
+	
+	/* Fault: all rails off at once, device in STANDBY */
+	void shutdown()
+	{
+		sequence = IDLE;
+		regs[R::ENABLE::__address] &= ~(R::ENABLE::ACTIVE::mask | R::ENABLE::STANDBY::mask);
+		regs[R::PG::__address] = 0;
+	}
+	
+	/* Earliest pending event, if any; everything due up to now has been processed */
+	bool nextEvent(uint32_t &next) const
+	{
+		bool any = false;
+		for (int rail = 0; rail < RAILS; rail++)
+			if (sequence != IDLE && railPending(rail))
+				earliest(any, next, rail_time[rail]);
+		if (sequence == POWER_DOWN)
+			earliest(any, next, down_end);
+		if (converting)
+			earliest(any, next, conversion_end);
+		if (acquiring)
+			earliest(any, next, acquisition_end);
+		if (programming)
+			earliest(any, next, programming_end);
+		return any;
+	}
+	
+	static void earliest(bool &any, uint32_t &next, uint32_t t)
+	{
+		if (!any || int32_t(t - next) < 0)
+			next = t;
+		any = true;
+	}
+	
+	/* Rail has not yet reached its target state in the running sequence */
+	bool railPending(int rail) const
+	{
+		bool on = regs[R::PG::__address] & railMask(rail);
+		return sequence == POWER_UP ? !on : on;
+	}
+	
+	/* Run everything due at the current time */
+	void process()
+	{
+		if (sequence != IDLE)
+		{
+			uint8_t &pg = regs[R::PG::__address];
+			for (int rail = 0; rail < RAILS; rail++)
+				if (int32_t(time - rail_time[rail]) >= 0)
+					setRail(pg, railMask(rail), sequence == POWER_UP);
+			if (sequence == POWER_UP && (pg & strobeRails) == strobeRails)
+			{
+				regs[R::ENABLE::__address] &= ~R::ENABLE::ACTIVE::mask;
+				sequence = IDLE;
+			}
+			else if (sequence == POWER_DOWN && int32_t(time - down_end) >= 0)
+			{
+				pg = 0;
+				regs[R::ENABLE::__address] &= ~R::ENABLE::STANDBY::mask;
+				sequence = IDLE;
+			}
+		}
+		if (converting && int32_t(time - conversion_end) >= 0)
+			completeConversion();
+		if (acquiring && int32_t(time - acquisition_end) >= 0)
+			completeAcquisition();
+		if (programming && int32_t(time - programming_end) >= 0)
+			completeProgramming();
+	}
+	
+	void completeConversion()
+	{
+		converting = false;
+		int value = temperature < -10 ? -10 : temperature > 85 ? 85 : temperature;
+		regs[R::TMST_VALUE::__address] = uint8_t(int8_t(value));
+		regs[R::TMST1::__address] = (regs[R::TMST1::__address] & ~R::TMST1::READ_THERM::mask)
+			| R::TMST1::CONV_END::mask;
+		
+		uint8_t int1 = 0;
+		int threshold = TPS65185_Units::dtCelsius(TPS65185_Base::extract<R::TMST1::DT>(regs[R::TMST1::__address]));
+		int delta = value - baseline;
+		if (delta >= threshold || -delta >= threshold)
+		{
+			int1 |= R::INT1::DTX::mask;
+			baseline = value;
+		}
+		uint8_t tmst2 = regs[R::TMST2::__address];
+		if (value >= TPS65185_Units::hotCelsius(TPS65185_Base::extract<R::TMST2::TMST_HOT>(tmst2)))
+			int1 |= R::INT1::TMST_HOT::mask;
+		if (value <= TPS65185_Units::coldCelsius(TPS65185_Base::extract<R::TMST2::TMST_COLD>(tmst2)))
+			int1 |= R::INT1::TMST_COLD::mask;
+		regs[R::INT1::__address] |= int1;
+		regs[R::INT2::__address] |= R::INT2::EOC::mask;
+	}
+	
+	void completeAcquisition()
+	{
+		acquiring = false;
+		regs[R::VCOM::__address] = kickback & 0xff;
+		regs[R::VCOM::__address + 1] = (regs[R::VCOM::__address + 1] & ~(R::VCOM::ACQ::mask >> 8) & ~1)
+			| (kickback >> 8);
+		regs[R::INT1::__address] |= R::INT1::ACQC::mask;
+	}
+	
+	void completeProgramming()
+	{
+		programming = false;
+		nvm_vcom = (regs[R::VCOM::__address] | (uint16_t(regs[R::VCOM::__address + 1]) << 8))
+			& R::VCOM::VCOM_::mask;
+		nvm_writes++;
+		regs[R::VCOM::__address + 1] &= ~(R::VCOM::PROG::mask >> 8);
+		regs[R::INT1::__address] |= R::INT1::PRGC::mask;
+		if (regs[R::PG::__address])
+			startPowerDown(programming_end);
+	}
+	
+	static const int RAILS = TPS65185_Timeline::RAILS;
+	
+	/* PG bit of a TPS65185_Timeline::Rail */
+	static uint8_t railMask(int rail)
+	{
+		static const uint8_t masks[RAILS] = {
+			R::PG::VDDH_PG::mask, R::PG::VPOS_PG::mask, R::PG::VEE_PG::mask, R::PG::VNEG_PG::mask
+		};
+		return masks[rail];
+	}
+	
+	uint8_t regs[R::__registers];
+	uint32_t time;
+	int temperature;
+	int baseline;
+	uint16_t kickback;
+	uint16_t nvm_vcom;
+	uint32_t transactions;
+	uint32_t nvm_writes;
+	
+	Sequence sequence;
+	uint32_t rail_time[RAILS];
+	uint32_t down_end;
+	bool converting;
+	uint32_t conversion_end;
+	bool acquiring;
+	uint32_t acquisition_end;
+	bool programming;
+	uint32_t programming_end;
+};
+
+#endif
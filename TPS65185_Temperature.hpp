@@ -0,0 +1,219 @@
+/*
+ * name:        TPS65185
+ * description: Panel temperature acquisition service for the TPS65185
+ * manuf:       Texas Instruments
+ * version:     0.1
+ * url:         http://www.ti.com/lit/ds/symlink/tps65185.pdf
+ * date:        2016-08-01
+ * author       https://chisl.io/
+ * file:        TPS65185_Temperature.hpp
+ */
+
+#ifndef TPS65185_TEMPERATURE_HPP
+#define TPS65185_TEMPERATURE_HPP
+
+#include "TPS65185.hpp"
+#include "TPS65185_Units.hpp"
+
+/*
+ * Serves the panel temperature from a cached, timestamped reading.
+ * start() sets TMST1::READ_THERM and returns at once. The conversion completes either
+ * from the EOC interrupt (subscribe onEOC() to INT2::EOC) or from tick(), which polls
+ * TMST1::CONV_END once conversion_us has passed. get() returns the cached reading while
+ * it is younger than the maximum age and starts a new conversion when it is not.
+ *
+ * In DTX mode the reading does not age. It stays valid until the device reports a change
+ * of TMST1::DT degrees or more through INT1::DTX (subscribe onDTX()); the next tick() then
+ * fetches the new TMST_VALUE left by the conversion that raised DTX. Conversions can be
+ * triggered from tick() every interval_us without reading their result, so that the device
+ * keeps comparing against its baseline. changes() counts readings that differ from the
+ * previous one, so dependent state such as a waveform table is only recomputed on change.
+ * Times are in microseconds from any free-running clock.
+ */
+template <class Device>
+class TPS65185_Temperature
+{
+public:
+	typedef void (*Callback)(void *context, int celsius);
+	
+	explicit TPS65185_Temperature(Device &device, uint32_t max_age_us = 10000000,
+		uint32_t conversion_us = 1000)
+		: device(device), max_age_us(max_age_us), conversion_us(conversion_us), callback(0),
+		  context(0), converting(false), eoc(false), valid(false), value(0), timestamp(0),
+		  next_poll(0), dtx_mode(false), dtx(false), dtx_interval_us(0), next_trigger(0), generation(0)
+	{
+	}
+	
+	/* Decode TMST_VALUE: signed degrees C, saturating at -10 and 85 */
+	static int decode(uint8_t raw)
+	{
+		return TPS65185_Units::tempCelsius(raw);
+	}
+	
+	/* Maximum age of a reading served by get() */
+	void setMaxAge(uint32_t max_age_us)
+	{
+		this->max_age_us = max_age_us;
+	}
+	
+	/* Called with every completed reading */
+	void setCallback(Callback callback, void *context = 0)
+	{
+		this->callback = callback;
+		this->context = context;
+	}
+	
+	/* Keep the reading until INT1::DTX; trigger unattended conversions every interval_us */
+	void setDTXMode(bool enabled, uint32_t now = 0, uint32_t interval_us = 0)
+	{
+		dtx_mode = enabled;
+		dtx_interval_us = interval_us;
+		next_trigger = now + interval_us;
+	}
+	
+	/* Start a conversion unless one is running */
+	void start(uint32_t now)
+	{
+		if (converting)
+			return;
+		converting = true;
+		eoc = false;
+		next_poll = now + conversion_us;
+		device.template set<typename Device::TMST1::READ_THERM>(1);
+	}
+	
+	/* Complete a running conversion when EOC was signalled or a poll is due */
+	void tick(uint32_t now)
+	{
+		if (dtx)
+		{
+			/* The conversion that raised DTX has already updated TMST_VALUE */
+			dtx = false;
+			if (!converting)
+			{
+				complete(now);
+				return;
+			}
+		}
+		if (!converting)
+		{
+			if (dtx_mode && dtx_interval_us && int32_t(now - next_trigger) >= 0)
+			{
+				next_trigger = now + dtx_interval_us;
+				device.template set<typename Device::TMST1::READ_THERM>(1);
+			}
+			return;
+		}
+		if (eoc)
+			complete(now);
+		else if (int32_t(now - next_poll) >= 0)
+		{
+			/* CONV_END is volatile: read it past the shadow cache */
+			if (device.read8(Device::TMST1::__address, 8) & Device::TMST1::CONV_END::mask)
+				complete(now);
+			else
+				next_poll = now + conversion_us;
+		}
+	}
+	
+	/* Handler for INT2::EOC, e.g. for TPS65185_Interrupts; completes on the next tick() */
+	static void onEOC(void *context, uint16_t events)
+	{
+		(void)events;
+		static_cast<TPS65185_Temperature *>(context)->eoc = true;
+	}
+	
+	/* Handler for INT1::DTX, e.g. for TPS65185_Interrupts; refreshes on the next tick() */
+	static void onDTX(void *context, uint16_t events)
+	{
+		(void)events;
+		static_cast<TPS65185_Temperature *>(context)->dtx = true;
+	}
+	
+	/* Cached reading if it is fresh; otherwise starts a conversion and returns false */
+	bool get(uint32_t now, int &celsius)
+	{
+		if (dtx && !converting)
+		{
+			dtx = false;
+			complete(now);
+		}
+		if (isFresh(now))
+		{
+			celsius = value;
+			return true;
+		}
+		start(now);
+		return false;
+	}
+	
+	/* Has a reading been taken less than the maximum age ago, or in DTX mode since the last DTX? */
+	bool isFresh(uint32_t now) const
+	{
+		if (dtx_mode)
+			return valid && !dtx;
+		return valid && now - timestamp <= max_age_us;
+	}
+	
+	/* Number of readings that differed from the one before */
+	uint32_t changes() const
+	{
+		return generation;
+	}
+	
+	bool isConverting() const
+	{
+		return converting;
+	}
+	
+	/* Last reading and its time, regardless of age */
+	int lastValue() const
+	{
+		return value;
+	}
+	
+	uint32_t lastTimestamp() const
+	{
+		return timestamp;
+	}
+	
+	/* Drop the cached reading */
+	void invalidate()
+	{
+		valid = false;
+	}
+	
+private:
+	void complete(uint32_t now)
+	{
+		converting = false;
+		eoc = false;
+		int previous = value;
+		value = decode(device.getTMST_VALUE());
+		if (!valid || value != previous)
+			generation++;
+		timestamp = now;
+		valid = true;
+		if (callback)
+			callback(context, value);
+	}
+	
+	Device &device;
+	uint32_t max_age_us;
+	uint32_t conversion_us;
+	Callback callback;
+	void *context;
+	bool converting;
+	bool eoc;
+	bool valid;
+	int value;
+	uint32_t timestamp;
+	uint32_t next_poll;
+	bool dtx_mode;
+	bool dtx;
+	uint32_t dtx_interval_us;
+	uint32_t next_trigger;
+	uint32_t generation;
+};
+
+#endif
@@ -0,0 +1,112 @@
+/*
+ * name:        TPS65185
+ * description: Power sequence timing model for the TPS65185
+ * manuf:       Texas Instruments
+ * version:     0.1
+ * url:         http://www.ti.com/lit/ds/symlink/tps65185.pdf
+ * date:        2016-08-01
+ * author       https://chisl.io/
+ * file:        TPS65185_Timing.hpp
+ */
+
+#ifndef TPS65185_TIMING_HPP
+#define TPS65185_TIMING_HPP
+
+#include "TPS65185.hpp"
+#include "TPS65185_Units.hpp"
+
+/*
+ * Timeline of a power-up or power-down sequence decoded from UPSEQ0/UPSEQ1 or
+ * DWNSEQ0/DWNSEQ1, in microseconds after the start of the sequence.
+ * Power-up starts when VN_PG goes high (pass the DC-DC soft-start time of the board as
+ * dcdc_us to count from ENABLE::ACTIVE instead); power-down starts at ENABLE::STANDBY.
+ * VPOS never switches on before or off after VNEG (see ENABLE::VPOS_EN).
+ * Rail ramp times are not included.
+ */
+struct TPS65185_Timeline
+{
+	typedef TPS65185_Base R;
+	
+	enum Rail { VDDH, VPOS, VEE, VNEG, RAILS };
+	
+	uint32_t strobe[4];    // STROBE1..STROBE4
+	uint32_t rail[RAILS];  // rail switches on (power-up) or off (power-down)
+	uint32_t done;         // sequence complete
+	
+	/* Power-up delay of an UPSEQ1 UDLYx code in us */
+	static uint32_t upDelay(uint8_t code)
+	{
+		return 1000 * TPS65185_Units::udlyMilliseconds(code);
+	}
+	
+	/* Power-down delay of a DWNSEQ1 DDLY2..DDLY4 code in us */
+	static uint32_t downDelay(uint8_t code, uint8_t dfctr)
+	{
+		return 1000 * TPS65185_Units::ddlyMilliseconds(code) * (dfctr == R::DWNSEQ1::DFCTR::multiply16x ? 16 : 1);
+	}
+	
+	static TPS65185_Timeline powerUp(uint8_t upseq0, uint8_t upseq1, uint32_t dcdc_us = 0)
+	{
+		TPS65185_Timeline t;
+		t.strobe[0] = dcdc_us + upDelay(R::extract<R::UPSEQ1::UDLY>(upseq1));
+		t.strobe[1] = t.strobe[0] + upDelay(R::extract<R::UPSEQ1::UDLY2>(upseq1));
+		t.strobe[2] = t.strobe[1] + upDelay(R::extract<R::UPSEQ1::UDLY3>(upseq1));
+		t.strobe[3] = t.strobe[2] + upDelay(R::extract<R::UPSEQ1::UDLY4>(upseq1));
+		t.assign(R::extract<R::UPSEQ0::VDDH_UP>(upseq0), R::extract<R::UPSEQ0::VPOS_UP>(upseq0),
+			R::extract<R::UPSEQ0::VEE_UP>(upseq0), R::extract<R::UPSEQ0::VNEG_UP>(upseq0));
+		if (t.rail[VPOS] < t.rail[VNEG])
+			t.rail[VPOS] = t.rail[VNEG];
+		t.done = t.latest();
+		return t;
+	}
+	
+	static TPS65185_Timeline powerDown(uint8_t dwnseq0, uint8_t dwnseq1)
+	{
+		TPS65185_Timeline t;
+		uint8_t dfctr = R::extract<R::DWNSEQ1::DFCTR>(dwnseq1);
+		t.strobe[0] = upDelay(R::extract<R::DWNSEQ1::DDLY1>(dwnseq1));
+		t.strobe[1] = t.strobe[0] + downDelay(R::extract<R::DWNSEQ1::DDLY2>(dwnseq1), dfctr);
+		t.strobe[2] = t.strobe[1] + downDelay(R::extract<R::DWNSEQ1::DDLY3>(dwnseq1), dfctr);
+		t.strobe[3] = t.strobe[2] + downDelay(R::extract<R::DWNSEQ1::DDLY4>(dwnseq1), dfctr);
+		t.assign(R::extract<R::DWNSEQ0::VDDH_DWN>(dwnseq0), R::extract<R::DWNSEQ0::VPOS_DWN>(dwnseq0),
+			R::extract<R::DWNSEQ0::VEE_DWN>(dwnseq0), R::extract<R::DWNSEQ0::VNEG_DWN>(dwnseq0));
+		if (t.rail[VPOS] > t.rail[VNEG])
+			t.rail[VPOS] = t.rail[VNEG];
+		t.done = t.strobe[3];
+		return t;
+	}
+	
+	/* Power-up timeline of the sequence currently programmed in device */
+	template <class Device>
+	static TPS65185_Timeline programmedPowerUp(Device &device, uint32_t dcdc_us = 0)
+	{
+		return powerUp(device.getUPSEQ0(), device.getUPSEQ1(), dcdc_us);
+	}
+	
+	/* Power-down timeline of the sequence currently programmed in device */
+	template <class Device>
+	static TPS65185_Timeline programmedPowerDown(Device &device)
+	{
+		return powerDown(device.getDWNSEQ0(), device.getDWNSEQ1());
+	}
+	
+private:
+	void assign(uint8_t vddh, uint8_t vpos, uint8_t vee, uint8_t vneg)
+	{
+		rail[VDDH] = strobe[vddh];
+		rail[VPOS] = strobe[vpos];
+		rail[VEE] = strobe[vee];
+		rail[VNEG] = strobe[vneg];
+	}
+	
+	uint32_t latest() const
+	{
+		uint32_t t = 0;
+		for (int i = 0; i < RAILS; i++)
+			if (rail[i] > t)
+				t = rail[i];
+		return t;
+	}
+};
+
+#endif
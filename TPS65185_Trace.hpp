@@ -0,0 +1,307 @@
+/*
+ * name:        TPS65185
+ * description: Bus transaction tracing for the TPS65185
+ * manuf:       Texas Instruments
+ * version:     0.1
+ * url:         http://www.ti.com/lit/ds/symlink/tps65185.pdf
+ * date:        2016-08-01
+ * author       https://chisl.io/
+ * file:        TPS65185_Trace.hpp
+ */
+
+#ifndef TPS65185_TRACE_HPP
+#define TPS65185_TRACE_HPP
+
+#include "TPS65185.hpp"
+
+/*
+ * Definitions shared by both variants of TPS65185_Traced.
+ *
+ * Per register address (bursts count at their start address) a Stats record holds the
+ * number of calls, the bytes moved, the longest latency and a histogram with bucket b
+ * counting latencies of 2^(b-1) to 2^b - 1 clock ticks (bucket 0: zero ticks).
+ *
+ * dump() format, all fields little endian:
+ *   header  "T185", version (1), record size (12), record count (16 bit)
+ *   record  time (32 bit), latency (16 bit, saturated), op, address, bytes, 0, value (16 bit)
+ * Records are oldest first; value holds the first one or two data bytes.
+ */
+struct TPS65185_Trace
+{
+	enum Op { READ8, WRITE8, READ16, WRITE16, READ_BURST, WRITE_BURST };
+	
+	static const uint8_t __buckets = 16;
+	static const uint8_t __version = 1;
+	static const uint8_t __header = 8;
+	static const uint8_t __record = 12;
+	
+	struct Stats
+	{
+		uint32_t calls;
+		uint32_t bytes;
+		uint32_t max;
+		uint32_t histogram[__buckets];
+	};
+	
+	/* Histogram bucket of a latency */
+	static uint8_t bucket(uint32_t latency)
+	{
+		uint8_t b = 0;
+		while (latency && b < __buckets - 1)
+		{
+			latency >>= 1;
+			b++;
+		}
+		return b;
+	}
+	
+	static void put16(uint8_t *out, uint16_t value)
+	{
+		out[0] = value & 0xff;
+		out[1] = value >> 8;
+	}
+	
+	static void put32(uint8_t *out, uint32_t value)
+	{
+		put16(out, value & 0xffff);
+		put16(out + 2, value >> 16);
+	}
+	
+	static uint16_t header(uint8_t *out, uint16_t records)
+	{
+		out[0] = 'T';
+		out[1] = '1';
+		out[2] = '8';
+		out[3] = '5';
+		out[4] = __version;
+		out[5] = __record;
+		put16(out + 6, records);
+		return __header;
+	}
+};
+
+#ifdef TPS65185_TRACE
+
+/*
+ * Transport decorator recording every transaction of Transport, e.g.
+ * TPS65185_Device<TPS65185_Traced<TPS65185_I2CDev<>, Clock> > or, where a TPS65185_Base is needed,
+ * TPS65185_Traced<TPS65185_I2CDev<TPS65185_Base>, Clock>.
+ * Clock provides static uint32_t now() in ticks of any unit, e.g. a cycle counter.
+ * The last Depth transactions are kept in a ring buffer. Recording is meant for a single
+ * thread, the one using the bus; other threads may read stats() and dump() at any time
+ * without locks. A record overwritten while dump() copies it is left out.
+ * Compiled only with TPS65185_TRACE defined; otherwise TPS65185_Traced is Transport itself
+ * with empty statistics, so tracing costs nothing.
+ */
+template <class Transport, class Clock, int Depth = 64>
+class TPS65185_Traced : public Transport
+{
+public:
+	typedef TPS65185_Trace::Stats Stats;
+	
+	TPS65185_Traced()
+	{
+		reset();
+	}
+	
+	explicit TPS65185_Traced(const Transport &transport) : Transport(transport)
+	{
+		reset();
+	}
+	
+	/* Transport interface */
+	uint8_t read8(uint16_t address, uint16_t n=8)
+	{
+		uint32_t start = Clock::now();
+		uint8_t value = Transport::read8(address, n);
+		record(TPS65185_Trace::READ8, address, 1, value, start);
+		return value;
+	}
+	
+	void write(uint16_t address, uint8_t value, uint16_t n=8)
+	{
+		uint32_t start = Clock::now();
+		Transport::write(address, value, n);
+		record(TPS65185_Trace::WRITE8, address, 1, value, start);
+	}
+	
+	uint16_t read16(uint16_t address, uint16_t n=16)
+	{
+		uint32_t start = Clock::now();
+		uint16_t value = Transport::read16(address, n);
+		record(TPS65185_Trace::READ16, address, 2, value, start);
+		return value;
+	}
+	
+	void write(uint16_t address, uint16_t value, uint16_t n=16)
+	{
+		uint32_t start = Clock::now();
+		Transport::write(address, value, n);
+		record(TPS65185_Trace::WRITE16, address, 2, value, start);
+	}
+	
+	void readBurst(uint16_t address, uint8_t *data, uint16_t count)
+	{
+		uint32_t start = Clock::now();
+		Transport::readBurst(address, data, count);
+		record(TPS65185_Trace::READ_BURST, address, count, first(data, count), start);
+	}
+	
+	void writeBurst(uint16_t address, const uint8_t *data, uint16_t count)
+	{
+		uint32_t start = Clock::now();
+		Transport::writeBurst(address, data, count);
+		record(TPS65185_Trace::WRITE_BURST, address, count, first(data, count), start);
+	}
+	
+	/* Statistics of register address */
+	const Stats &stats(uint16_t address) const
+	{
+		return address < TPS65185_Base::__registers ? registers[address] : other;
+	}
+	
+	/* Number of transactions recorded since reset() */
+	uint32_t transactions() const
+	{
+		return head;
+	}
+	
+	/* Clear statistics and the ring buffer */
+	void reset()
+	{
+		for (uint16_t i = 0; i < TPS65185_Base::__registers; i++)
+			clear(registers[i]);
+		clear(other);
+		head = 0;
+	}
+	
+	/* Write the header and up to the last Depth - 1 records to out; returns the bytes used */
+	uint16_t dump(uint8_t *out, uint16_t size) const
+	{
+		if (size < TPS65185_Trace::__header)
+			return 0;
+		uint32_t end = head;
+		__sync_synchronize();
+		uint32_t count = end < uint32_t(Depth) ? end : Depth;
+		uint16_t room = (size - TPS65185_Trace::__header) / TPS65185_Trace::__record;
+		if (count > room)
+			count = room;
+		uint8_t *p = out + TPS65185_Trace::__header;
+		for (uint32_t i = end - count; i != end; i++)
+		{
+			const Entry &entry = ring[i % Depth];
+			TPS65185_Trace::put32(p, entry.time);
+			TPS65185_Trace::put16(p + 4, entry.latency);
+			p[6] = entry.op;
+			p[7] = entry.address;
+			p[8] = entry.bytes;
+			p[9] = 0;
+			TPS65185_Trace::put16(p + 10, entry.value);
+			p += TPS65185_Trace::__record;
+		}
+		/* Drop the oldest records if the writer has reused their slots meanwhile */
+		__sync_synchronize();
+		uint32_t reused = head - end + 1;  // including the one being written
+		uint32_t spare = Depth - count;
+		uint32_t dropped = reused <= spare ? 0 : reused - spare < count ? reused - spare : count;
+		uint8_t *records = out + TPS65185_Trace::__header;
+		uint16_t kept = count - dropped;
+		for (uint16_t i = 0; i < kept * TPS65185_Trace::__record; i++)
+			records[i] = records[i + dropped * TPS65185_Trace::__record];
+		return TPS65185_Trace::header(out, kept) + kept * TPS65185_Trace::__record;
+	}
+	
+private:
+	struct Entry
+	{
+		uint32_t time;
+		uint16_t latency;
+		uint8_t op;
+		uint8_t address;
+		uint8_t bytes;
+		uint16_t value;
+	};
+	
+	static void clear(Stats &stats)
+	{
+		stats.calls = stats.bytes = stats.max = 0;
+		for (uint8_t b = 0; b < TPS65185_Trace::__buckets; b++)
+			stats.histogram[b] = 0;
+	}
+	
+	static uint16_t first(const uint8_t *data, uint16_t count)
+	{
+		return count == 0 ? 0 : count == 1 ? data[0] : data[0] | (uint16_t(data[1]) << 8);
+	}
+	
+	void record(TPS65185_Trace::Op op, uint16_t address, uint16_t bytes, uint16_t value, uint32_t start)
+	{
+		uint32_t now = Clock::now();
+		uint32_t latency = now - start;
+		Stats &counters = address < TPS65185_Base::__registers ? registers[address] : other;
+		counters.calls++;
+		counters.bytes += bytes;
+		if (latency > counters.max)
+			counters.max = latency;
+		counters.histogram[TPS65185_Trace::bucket(latency)]++;
+		
+		Entry &entry = ring[head % Depth];
+		entry.time = start;
+		entry.latency = latency > 0xffff ? 0xffff : latency;
+		entry.op = op;
+		entry.address = address;
+		entry.bytes = bytes > 0xff ? 0xff : bytes;
+		entry.value = value;
+		/* Publish the entry before advancing head */
+		__sync_synchronize();
+		head = head + 1;
+	}
+	
+	Stats registers[TPS65185_Base::__registers];
+	Stats other;  // addresses beyond the register file
+	Entry ring[Depth];
+	volatile uint32_t head;
+};
+
+#else
+
+/* Tracing compiled out: Transport unchanged, statistics always empty */
+template <class Transport, class Clock, int Depth = 64>
+class TPS65185_Traced : public Transport
+{
+public:
+	typedef TPS65185_Trace::Stats Stats;
+	
+	TPS65185_Traced()
+	{
+	}
+	
+	explicit TPS65185_Traced(const Transport &transport) : Transport(transport)
+	{
+	}
+	
+	const Stats &stats(uint16_t address) const
+	{
+		(void)address;
+		static const Stats none = Stats();
+		return none;
+	}
+	
+	uint32_t transactions() const
+	{
+		return 0;
+	}
+	
+	void reset()
+	{
+	}
+	
+	uint16_t dump(uint8_t *out, uint16_t size) const
+	{
+		return size < TPS65185_Trace::__header ? 0 : TPS65185_Trace::header(out, 0);
+	}
+};
+
+#endif
+
+#endif
@@ -0,0 +1,208 @@
+/*
+ * name:        TPS65185
+ * description: Unit conversions for the TPS65185 register fields
+ * manuf:       Texas Instruments
+ * version:     0.1
+ * url:         http://www.ti.com/lit/ds/symlink/tps65185.pdf
+ * date:        2016-08-01
+ * author       https://chisl.io/
+ * file:        TPS65185_Units.hpp
+ */
+
+#ifndef TPS65185_UNITS_HPP
+#define TPS65185_UNITS_HPP
+
+#include "TPS65185.hpp"
+
+/* Compile-time range check: TPS65185_Check<false> is incomplete, so sizeof fails */
+template <bool> struct TPS65185_Check;
+template <> struct TPS65185_Check<true> { enum { ok = 1 }; };
+
+/*
+ * Compile-time conversions of constants; the value is an enum, so no code is generated.
+ * An argument out of range or off the register's step fails to compile, e.g.
+ * TPS65185_VCOMCode<-1255>::value.
+ */
+
+/* VCOM[8:0] from mV: VCOM = -10 mV * VCOM[8:0], 0 mV to -5110 mV */
+template <int mV>
+struct TPS65185_VCOMCode
+{
+	enum { __check = sizeof(TPS65185_Check<(mV <= 0 && mV >= -5110 && mV % 10 == 0)>) };
+	enum { value = -mV / 10 };
+};
+
+/* mV from VCOM[8:0] */
+template <unsigned code>
+struct TPS65185_VCOMMillivolts
+{
+	enum { __check = sizeof(TPS65185_Check<(code <= 0x1ff)>) };
+	enum { value = -10 * int(code) };
+};
+
+/* TMST_VALUE from C, -10 to 85 C */
+template <int celsius>
+struct TPS65185_TempCode
+{
+	enum { __check = sizeof(TPS65185_Check<(celsius >= -10 && celsius <= 85)>) };
+	enum { value = celsius & 0xff };
+};
+
+/* TMST2::TMST_COLD from C: temp = -7C + TMST_COLD */
+template <int celsius>
+struct TPS65185_ColdCode
+{
+	enum { __check = sizeof(TPS65185_Check<(celsius >= -7 && celsius <= 8)>) };
+	enum { value = celsius + 7 };
+};
+
+/* C from TMST2::TMST_COLD */
+template <unsigned code>
+struct TPS65185_ColdCelsius
+{
+	enum { __check = sizeof(TPS65185_Check<(code <= 15)>) };
+	enum { value = -7 + int(code) };
+};
+
+/* TMST2::TMST_HOT from C: temp = 42C + TMST_HOT */
+template <int celsius>
+struct TPS65185_HotCode
+{
+	enum { __check = sizeof(TPS65185_Check<(celsius >= 42 && celsius <= 57)>) };
+	enum { value = celsius - 42 };
+};
+
+/* C from TMST2::TMST_HOT */
+template <unsigned code>
+struct TPS65185_HotCelsius
+{
+	enum { __check = sizeof(TPS65185_Check<(code <= 15)>) };
+	enum { value = 42 + int(code) };
+};
+
+/* TMST1::DT from C, 2 to 5 C */
+template <int celsius>
+struct TPS65185_DTCode
+{
+	enum { __check = sizeof(TPS65185_Check<(celsius >= 2 && celsius <= 5)>) };
+	enum { value = celsius - 2 };
+};
+
+/* UPSEQ1::UDLYx from ms, 3/6/9/12 ms */
+template <unsigned ms>
+struct TPS65185_UDLYCode
+{
+	enum { __check = sizeof(TPS65185_Check<(ms >= 3 && ms <= 12 && ms % 3 == 0)>) };
+	enum { value = ms / 3 - 1 };
+};
+
+/* ms from UPSEQ1::UDLYx */
+template <unsigned code>
+struct TPS65185_UDLYMilliseconds
+{
+	enum { __check = sizeof(TPS65185_Check<(code <= 3)>) };
+	enum { value = 3 * (code + 1) };
+};
+
+/* DWNSEQ1::DDLY2..DDLY4 from ms, 6/12/24/48 ms (before DFCTR) */
+template <unsigned ms> struct TPS65185_DDLYCode;
+template <> struct TPS65185_DDLYCode<6> { enum { value = 0 }; };
+template <> struct TPS65185_DDLYCode<12> { enum { value = 1 }; };
+template <> struct TPS65185_DDLYCode<24> { enum { value = 2 }; };
+template <> struct TPS65185_DDLYCode<48> { enum { value = 3 }; };
+
+/* ms from DWNSEQ1::DDLY2..DDLY4 (before DFCTR) */
+template <unsigned code>
+struct TPS65185_DDLYMilliseconds
+{
+	enum { __check = sizeof(TPS65185_Check<(code <= 3)>) };
+	enum { value = 6 << code };
+};
+
+/* VADJ::VSET from mV, 14500/14750/15000/15250 mV */
+template <int mV> struct TPS65185_VSETCode;
+template <> struct TPS65185_VSETCode<15000> { enum { value = TPS65185_Base::VADJ::VSET::V15 }; };
+template <> struct TPS65185_VSETCode<14750> { enum { value = TPS65185_Base::VADJ::VSET::V14_75 }; };
+template <> struct TPS65185_VSETCode<14500> { enum { value = TPS65185_Base::VADJ::VSET::V14_5 }; };
+template <> struct TPS65185_VSETCode<15250> { enum { value = TPS65185_Base::VADJ::VSET::V15_25 }; };
+
+/* mV from VADJ::VSET; only the valid settings are defined */
+template <unsigned code> struct TPS65185_VSETMillivolts;
+template <> struct TPS65185_VSETMillivolts<TPS65185_Base::VADJ::VSET::V15> { enum { value = 15000 }; };
+template <> struct TPS65185_VSETMillivolts<TPS65185_Base::VADJ::VSET::V14_75> { enum { value = 14750 }; };
+template <> struct TPS65185_VSETMillivolts<TPS65185_Base::VADJ::VSET::V14_5> { enum { value = 14500 }; };
+template <> struct TPS65185_VSETMillivolts<TPS65185_Base::VADJ::VSET::V15_25> { enum { value = 15250 }; };
+
+/*
+ * Run-time conversions of values only known at run time. Code to unit needs no division;
+ * unit to code saturates at the ends of the register range.
+ */
+struct TPS65185_Units
+{
+	static int vcomMillivolts(uint16_t code)
+	{
+		return -10 * int(code & 0x1ff);
+	}
+	
+	/* Rounded to the nearest 10 mV step */
+	static uint16_t vcomCode(int mV)
+	{
+		return mV >= 0 ? 0 : mV <= -5110 ? 0x1ff : (5 - mV) / 10;
+	}
+	
+	/* TMST_VALUE is a signed byte, saturated by the device at -10 and 85 C */
+	static int tempCelsius(uint8_t code)
+	{
+		return int8_t(code);
+	}
+	
+	static int coldCelsius(uint8_t code)
+	{
+		return -7 + (code & 0xf);
+	}
+	
+	static uint8_t coldCode(int celsius)
+	{
+		return saturate(celsius + 7, 15);
+	}
+	
+	static int hotCelsius(uint8_t code)
+	{
+		return 42 + (code & 0xf);
+	}
+	
+	static uint8_t hotCode(int celsius)
+	{
+		return saturate(celsius - 42, 15);
+	}
+	
+	static int dtCelsius(uint8_t code)
+	{
+		return 2 + (code & 0x3);
+	}
+	
+	static unsigned udlyMilliseconds(uint8_t code)
+	{
+		return 3 * ((code & 0x3) + 1);
+	}
+	
+	static unsigned ddlyMilliseconds(uint8_t code)
+	{
+		return 6 << (code & 0x3);
+	}
+	
+	/* 0 for the settings marked not valid or reserved */
+	static int vsetMillivolts(uint8_t code)
+	{
+		static const int16_t mV[8] = { 0, 0, 0, 15000, 14750, 14500, 15250, 0 };
+		return mV[code & 0x7];
+	}
+	
+private:
+	static uint8_t saturate(int code, int max)
+	{
+		return code < 0 ? 0 : code > max ? max : code;
+	}
+};
+
+#endif
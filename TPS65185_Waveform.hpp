@@ -0,0 +1,91 @@
+/*
+ * name:        TPS65185
+ * description: Temperature-indexed waveform mode selector for the TPS65185
+ * manuf:       Texas Instruments
+ * version:     0.1
+ * url:         http://www.ti.com/lit/ds/symlink/tps65185.pdf
+ * date:        2016-08-01
+ * author       https://chisl.io/
+ * file:        TPS65185_Waveform.hpp
+ */
+
+#ifndef TPS65185_WAVEFORM_HPP
+#define TPS65185_WAVEFORM_HPP
+
+#include "TPS65185.hpp"
+#include "TPS65185_Units.hpp"
+
+/*
+ * Maps raw TMST_VALUE codes to waveform temperature bands through a 256 entry table
+ * built once from the band boundaries, so a lookup is a single array access.
+ * n ascending boundaries in degrees C give n + 1 bands: band 0 is below boundary[0],
+ * band i covers boundary[i-1] <= temp < boundary[i] and band n is boundary[n-1] and up.
+ * tmst2() places the TMST2 COLD threshold at the top of band 0 and the HOT threshold at
+ * the bottom of band n, so INT1::TMST_COLD/TMST_HOT signal entering the outermost bands.
+ * Thresholds outside the hardware range (COLD -7..8 C, HOT 42..57 C) are clamped.
+ * No boundaries, or boundaries not strictly ascending, are rejected: isValid() is false,
+ * every code maps to band 0 and program() leaves the device unchanged.
+ */
+class TPS65185_Waveform
+{
+public:
+	TPS65185_Waveform(const int *boundary, uint8_t count) : valid(count > 0), cold(0), hot(0)
+	{
+		for (uint8_t i = 1; valid && i < count; i++)
+			if (boundary[i] <= boundary[i - 1])
+				valid = false;
+		if (valid)
+		{
+			cold = boundary[0] - 1;
+			hot = boundary[count - 1];
+		}
+		else
+			count = 0;
+		for (unsigned raw = 0; raw < 256; raw++)
+		{
+			int celsius = int8_t(raw);
+			uint8_t band = 0;
+			while (band < count && celsius >= boundary[band])
+				band++;
+			table[raw] = band;
+		}
+	}
+	
+	/* Were the boundaries accepted? */
+	bool isValid() const
+	{
+		return valid;
+	}
+	
+	/* Band of a raw TMST_VALUE code */
+	uint8_t band(uint8_t raw) const
+	{
+		return table[raw];
+	}
+	
+	/* TMST2 value with thresholds following the outermost bands */
+	uint8_t tmst2() const
+	{
+		return TPS65185_Base::insert<TPS65185_Base::TMST2::TMST_COLD>(
+			TPS65185_Base::insert<TPS65185_Base::TMST2::TMST_HOT>(0, TPS65185_Units::hotCode(hot)),
+			TPS65185_Units::coldCode(cold));
+	}
+	
+	/* Program the TMST2 thresholds of device; false if the boundaries were rejected */
+	template <class Device>
+	bool program(Device &device) const
+	{
+		if (!valid)
+			return false;
+		device.setTMST2(tmst2());
+		return true;
+	}
+	
+private:
+	bool valid;
+	int cold;
+	int hot;
+	uint8_t table[256];
+};
+
+#endif
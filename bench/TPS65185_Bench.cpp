@@ -0,0 +1,329 @@
+/*
+ * name:        TPS65185
+ * description: Microbenchmarks of the TPS65185 register API
+ * manuf:       Texas Instruments
+ * version:     0.1
+ * url:         http://www.ti.com/lit/ds/symlink/tps65185.pdf
+ * date:        2016-08-01
+ * author       https://chisl.io/
+ * file:        TPS65185_Bench.cpp
+ */
+
+/*
+ * Measures the host-side cost of the register API and the bus load of high-level
+ * operations, to track performance regressions. Build and run from the repository root:
+ *
+ *   g++ -O2 -std=c++11 -I. bench/TPS65185_Bench.cpp -o tps65185_bench && ./tps65185_bench [iterations]
+ *
+ * Accessor costs are ns/op against an in-memory transport, which costs one volatile access
+ * per register, so the numbers are dominated by the API itself:
+ * - virtual: TPS65185_Base, dispatched through the vtable
+ * - static:  TPS65185_Device<Memory<> >, inlinable
+ * - cached:  static with the shadow cache enabled; bus/op is the share reaching the transport
+ * Bus transactions per operation are counted on TPS65185_Sim, uncached and cached.
+ */
+
+#include "TPS65185.hpp"
+#include "TPS65185_Sim.hpp"
+#include "TPS65185_Sequencer.hpp"
+#include "TPS65185_Temperature.hpp"
+#include "TPS65185_Batch.hpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/* In-memory register file as transport */
+template <class Base = TPS65185_NoBase>
+class Memory : public Base
+{
+public:
+	Memory() : transactions(0)
+	{
+		for (uint16_t i = 0; i < TPS65185_Base::__registers + 1; i++)
+			regs[i] = 0;
+	}
+	
+	uint8_t read8(uint16_t address, uint16_t n=8)
+	{
+		(void)n;
+		transactions++;
+		return regs[address];
+	}
+	
+	void write(uint16_t address, uint8_t value, uint16_t n=8)
+	{
+		(void)n;
+		transactions++;
+		regs[address] = value;
+	}
+	
+	uint16_t read16(uint16_t address, uint16_t n=16)
+	{
+		(void)n;
+		transactions++;
+		return regs[address] | (uint16_t(regs[address + 1]) << 8);
+	}
+	
+	void write(uint16_t address, uint16_t value, uint16_t n=16)
+	{
+		(void)n;
+		transactions++;
+		regs[address] = value & 0xff;
+		regs[address + 1] = value >> 8;
+	}
+	
+	void readBurst(uint16_t address, uint8_t *data, uint16_t count)
+	{
+		transactions++;
+		for (uint16_t i = 0; i < count; i++)
+			data[i] = regs[address + i];
+	}
+	
+	void writeBurst(uint16_t address, const uint8_t *data, uint16_t count)
+	{
+		transactions++;
+		for (uint16_t i = 0; i < count; i++)
+			regs[address + i] = data[i];
+	}
+	
+	volatile uint8_t regs[TPS65185_Base::__registers + 1];
+	uint32_t transactions;
+};
+
+typedef TPS65185_Device<Memory<> > Static;
+typedef Memory<TPS65185_Base> Virtual;
+typedef TPS65185_Device<TPS65185_Sim<> > Sim;
+
+static volatile uint32_t sink;
+
+static double nanoseconds()
+{
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* ns per call of op */
+template <class Device, class Op>
+double measure(Device &device, Op op, uint32_t iterations)
+{
+	double start = nanoseconds();
+	for (uint32_t i = 0; i < iterations; i++)
+		op(device, i);
+	return (nanoseconds() - start) / iterations;
+}
+
+/* Accessor functors for every register */
+#define TPS65185_BENCH_REGISTERS(X) \
+	X(TMST_VALUE) X(ENABLE) X(VADJ) X(VCOM) X(INT_EN1) X(INT_EN2) X(INT1) X(INT2) \
+	X(UPSEQ0) X(UPSEQ1) X(DWNSEQ0) X(DWNSEQ1) X(TMST1) X(TMST2) X(PG) X(REVID)
+
+#define TPS65185_BENCH_ACCESSORS(NAME) \
+	struct Get##NAME \
+	{ \
+		template <class Device> void operator()(Device &device, uint32_t) const { sink = device.get##NAME(); } \
+	}; \
+	struct Set##NAME \
+	{ \
+		template <class Device> void operator()(Device &device, uint32_t i) const { device.set##NAME(i & 0x1f); } \
+	};
+
+TPS65185_BENCH_REGISTERS(TPS65185_BENCH_ACCESSORS)
+
+/* One row of the accessor table */
+template <class Get, class Set>
+void accessor(const char *name, uint32_t iterations)
+{
+	Virtual memory;
+	/* Keep the compiler from devirtualizing the calls */
+	TPS65185_Base *volatile pointer = &memory;
+	TPS65185_Base &dynamic = *pointer;
+	Static plain;
+	Static cached;
+	cached.setCacheEnabled(true);
+	
+	double get_virtual = measure(dynamic, Get(), iterations);
+	double get_static = measure(plain, Get(), iterations);
+	cached.transactions = 0;
+	double get_cached = measure(cached, Get(), iterations);
+	double get_bus = double(cached.transactions) / iterations;
+	double set_virtual = measure(dynamic, Set(), iterations);
+	double set_static = measure(plain, Set(), iterations);
+	double set_cached = measure(cached, Set(), iterations);
+	printf("%-12s %8.2f %8.2f %8.2f %6.2f   %8.2f %8.2f %8.2f\n", name, get_virtual, get_static, get_cached,
+		get_bus, set_virtual, set_static, set_cached);
+}
+
+#define TPS65185_BENCH_ROW(NAME) accessor<Get##NAME, Set##NAME>(#NAME, iterations);
+
+/* All registers one by one or in one burst */
+struct Single
+{
+	template <class Device> void operator()(Device &device, uint32_t) const
+	{
+		for (uint16_t address = 0; address < TPS65185_Base::__registers; address++)
+			sink = device.read8(address);
+	}
+};
+
+struct Burst
+{
+	template <class Device> void operator()(Device &device, uint32_t) const
+	{
+		typename Device::Snapshot snapshot;
+		device.readSnapshot(snapshot);
+		sink = snapshot.pg;
+	}
+};
+
+/* Bus transactions of high-level operations on the simulator */
+static void settle(Sim &device, TPS65185_Sequencer<Sim> &sequencer)
+{
+	while (sequencer.isBusy())
+	{
+		device.advance(sequencer.nextPoll() - device.now());
+		sequencer.tick(device.now());
+	}
+}
+
+static uint32_t powerUp(bool cache)
+{
+	Sim device;
+	device.setCacheEnabled(cache);
+	TPS65185_Sequencer<Sim> sequencer(device);
+	/* Warm up: a cached device reads the sequence registers once */
+	sequencer.powerUp(device.now());
+	settle(device, sequencer);
+	sequencer.powerDown(device.now());
+	settle(device, sequencer);
+	uint32_t start = device.busTransactions();
+	sequencer.powerUp(device.now());
+	settle(device, sequencer);
+	return device.busTransactions() - start;
+}
+
+static uint32_t powerDown(bool cache)
+{
+	Sim device;
+	device.setCacheEnabled(cache);
+	TPS65185_Sequencer<Sim> sequencer(device);
+	/* Warm up as for powerUp() */
+	sequencer.powerUp(device.now());
+	settle(device, sequencer);
+	sequencer.powerDown(device.now());
+	settle(device, sequencer);
+	sequencer.powerUp(device.now());
+	settle(device, sequencer);
+	uint32_t start = device.busTransactions();
+	sequencer.powerDown(device.now());
+	settle(device, sequencer);
+	return device.busTransactions() - start;
+}
+
+static uint32_t temperature(bool cache)
+{
+	Sim device;
+	device.setCacheEnabled(cache);
+	TPS65185_Temperature<Sim> service(device);
+	int celsius;
+	/* Warm up: the first set<READ_THERM>() of a cached device reads TMST1 */
+	service.get(device.now(), celsius);
+	device.advance(Sim::__conversion_us);
+	service.tick(device.now());
+	service.invalidate();
+	uint32_t start = device.busTransactions();
+	service.get(device.now(), celsius);
+	device.advance(Sim::__conversion_us);
+	service.tick(device.now());
+	return device.busTransactions() - start;
+}
+
+static uint32_t configure(bool cache)
+{
+	Sim device;
+	device.setCacheEnabled(cache);
+	uint32_t start = device.busTransactions();
+	device.setUPSEQ0(0xe4);
+	device.setUPSEQ1(0x55);
+	device.setDWNSEQ0(0x1e);
+	device.setDWNSEQ1(0xe0);
+	device.setTMST2(0x78);
+	device.setINT_EN1(0x7f);
+	device.setINT_EN2(0xff);
+	return device.busTransactions() - start;
+}
+
+static uint32_t configureBatch(bool cache)
+{
+	Sim device;
+	device.setCacheEnabled(cache);
+	TPS65185_Batch<Sim> batch(device);
+	uint32_t start = device.busTransactions();
+	batch.write(Sim::UPSEQ0::__address, uint8_t(0xe4));
+	batch.write(Sim::UPSEQ1::__address, uint8_t(0x55));
+	batch.write(Sim::DWNSEQ0::__address, uint8_t(0x1e));
+	batch.write(Sim::DWNSEQ1::__address, uint8_t(0xe0));
+	batch.write(Sim::TMST2::__address, uint8_t(0x78));
+	batch.write(Sim::INT_EN1::__address, uint8_t(0x7f));
+	batch.write(Sim::INT_EN2::__address, uint8_t(0xff));
+	batch.commit();
+	return device.busTransactions() - start;
+}
+
+static uint32_t interrupts(bool cache)
+{
+	Sim device;
+	device.setCacheEnabled(cache);
+	uint32_t start = device.busTransactions();
+	sink = device.getInterrupts().value;
+	return device.busTransactions() - start;
+}
+
+static uint32_t interruptsSingle(bool cache)
+{
+	Sim device;
+	device.setCacheEnabled(cache);
+	uint32_t start = device.busTransactions();
+	sink = device.getINT1() | (device.getINT2() << 8);
+	return device.busTransactions() - start;
+}
+
+static void operation(const char *name, uint32_t (*count)(bool cache))
+{
+	printf("%-28s %9u %9u\n", name, count(false), count(true));
+}
+
+int main(int argc, char **argv)
+{
+	uint32_t iterations = argc > 1 ? strtoul(argv[1], 0, 0) : 1000000;
+	if (!iterations)
+		iterations = 1;
+	
+	printf("accessors, ns/op (%u iterations)\n", iterations);
+	printf("%-12s %8s %8s %8s %6s   %8s %8s %8s\n", "register", "get virt", "static", "cached", "bus/op",
+		"set virt", "static", "cached");
+	TPS65185_BENCH_REGISTERS(TPS65185_BENCH_ROW)
+	
+	Static single;
+	Static burst;
+	double single_ns = measure(single, Single(), iterations);
+	single.transactions = 0;
+	measure(single, Single(), 1);
+	double burst_ns = measure(burst, Burst(), iterations);
+	burst.transactions = 0;
+	measure(burst, Burst(), 1);
+	printf("\nall registers          ns/op  bus/op\n");
+	printf("%-20s %8.2f %7u\n", "single read8()", single_ns, single.transactions);
+	printf("%-20s %8.2f %7u\n", "readSnapshot()", burst_ns, burst.transactions);
+	
+	printf("\nbus transactions per operation  uncached    cached\n");
+	operation("power-up (sequencer)", powerUp);
+	operation("power-down (sequencer)", powerDown);
+	operation("temperature read", temperature);
+	operation("configuration, setXXX()", configure);
+	operation("configuration, batch", configureBatch);
+	operation("INT1+INT2, getINTx()", interruptsSingle);
+	operation("INT1+INT2, getInterrupts()", interrupts);
+	return 0;
+}
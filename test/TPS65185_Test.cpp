@@ -0,0 +1,1617 @@
+/*
+ * name:        TPS65185
+ * description: Host-side regression tests of the TPS65185 driver
+ * manuf:       Texas Instruments
+ * version:     0.1
+ * url:         http://www.ti.com/lit/ds/symlink/tps65185.pdf
+ * date:        2016-08-01
+ * author       https://chisl.io/
+ * file:        TPS65185_Test.cpp
+ */
+
+/*
+ * Runs the driver against TPS65185_Sim, no hardware needed. Build and run from the
+ * repository root:
+ *
+ *   g++ -std=c++11 -Wall -Wextra -pthread -I. test/TPS65185_Test.cpp -o tps65185_test && ./tps65185_test
+ *
+ * Prints every failed check and exits with status 1 if there was any. Add -DTPS65185_TRACE
+ * to also check the recording of TPS65185_Traced.
+ */
+
+#include "TPS65185.hpp"
+#include "TPS65185_Sim.hpp"
+#include "TPS65185_Fleet.hpp"
+#include "TPS65185_I2CDev.hpp"
+#include "TPS65185_Shared.hpp"
+#include "TPS65185_Sequencer.hpp"
+#include "TPS65185_Temperature.hpp"
+#include "TPS65185_Calibration.hpp"
+#include "TPS65185_Profile.hpp"
+#include "TPS65185_Recovery.hpp"
+#include "TPS65185_Programmer.hpp"
+#include "TPS65185_Waveform.hpp"
+#include "TPS65185_Timing.hpp"
+#include "TPS65185_Optimizer.hpp"
+#include "TPS65185_Interrupts.hpp"
+#include "TPS65185_Units.hpp"
+#include "TPS65185_Batch.hpp"
+#include "TPS65185_Trace.hpp"
+#include "TPS65185_PowerGood.hpp"
+
+#include <stdio.h>
+
+typedef TPS65185_Device<TPS65185_Sim<> > Device;
+
+static int failures = 0;
+
+#define CHECK(condition) check(condition, #condition, __LINE__)
+
+static void check(bool condition, const char *text, int line)
+{
+	if (!condition)
+	{
+		printf("%s:%d: check failed: %s\n", __FILE__, line, text);
+		failures++;
+	}
+}
+
+
+/*****************************************************************************************************\
+ *                                                                                                   *
+ *                                             SIMULATOR                                             *
+ *                                                                                                   *
+\*****************************************************************************************************/
+
+/* Default UPSEQ0/UPSEQ1: VNEG, VEE, VPOS, VDDH at 6 ms intervals after ENABLE::ACTIVE */
+static void testSimPowerUpTiming()
+{
+	Device device;
+	device.set<Device::ENABLE::ACTIVE>(1);
+	CHECK(device.getPG() == (Device::PG::VB_PG::mask | Device::PG::VN_PG::mask));
+	device.advance(5999);
+	CHECK(!device.get<Device::PG::VNEG_PG>());
+	device.advance(1);
+	CHECK(device.get<Device::PG::VNEG_PG>());
+	CHECK(!device.get<Device::PG::VEE_PG>());
+	device.advance(6000);
+	CHECK(device.get<Device::PG::VEE_PG>());
+	CHECK(!device.get<Device::PG::VPOS_PG>());
+	device.advance(6000);
+	CHECK(device.get<Device::PG::VPOS_PG>());
+	CHECK(!device.powerGood());
+	device.advance(6000);
+	CHECK(device.get<Device::PG::VDDH_PG>());
+	CHECK(device.powerGood());
+}
+
+/* Default DWNSEQ0/DWNSEQ1: all rails off once the sequence ends */
+static void testSimPowerDownTiming()
+{
+	Device device;
+	device.set<Device::ENABLE::ACTIVE>(1);
+	device.advance(24000);
+	CHECK(device.powerGood());
+	device.set<Device::ENABLE::STANDBY>(1);
+	CHECK(device.read8(Device::ENABLE::__address) & Device::ENABLE::STANDBY::mask);
+	device.advance(1000000);
+	CHECK(device.getPG() == 0);
+	CHECK(!device.powerGood());
+}
+
+/* ENABLE writes that leave the rail bits alone do not touch rails brought up by a sequence */
+static void testSimVCOMEnableKeepsRails()
+{
+	Device device;
+	device.set<Device::ENABLE::ACTIVE>(1);
+	device.advance(24000);
+	CHECK(device.powerGood());
+	device.set<Device::ENABLE::VCOM_EN>(1);
+	CHECK(device.powerGood());
+	CHECK(device.getPG() == 0xfa);
+	
+	/* Changing a rail bit is manual rail control */
+	device.set<Device::ENABLE::VNEG_EN>(1);
+	CHECK(device.getPG() == (Device::PG::VB_PG::mask | Device::PG::VN_PG::mask | Device::PG::VNEG_PG::mask));
+}
+
+/* ACTIVE, STANDBY, READ_THERM, CONV_END and ACQ read back as set until the device clears them */
+static void testSimSelfClearingBits()
+{
+	Device device;
+	device.set<Device::ENABLE::ACTIVE>(1);
+	CHECK(device.read8(Device::ENABLE::__address) & Device::ENABLE::ACTIVE::mask);
+	device.advance(24000);
+	CHECK(!(device.read8(Device::ENABLE::__address) & Device::ENABLE::ACTIVE::mask));
+	
+	device.setTemperature(30);
+	device.set<Device::TMST1::READ_THERM>(1);
+	uint8_t tmst1 = device.read8(Device::TMST1::__address);
+	CHECK(tmst1 & Device::TMST1::READ_THERM::mask);
+	CHECK(!(tmst1 & Device::TMST1::CONV_END::mask));
+	device.advance(TPS65185_Sim<>::__conversion_us);
+	tmst1 = device.read8(Device::TMST1::__address);
+	CHECK(!(tmst1 & Device::TMST1::READ_THERM::mask));
+	CHECK(tmst1 & Device::TMST1::CONV_END::mask);
+	CHECK(device.getTMST_VALUE() == 30);
+	
+	device.setKickback(0x123);
+	device.set<Device::VCOM::ACQ>(1);
+	CHECK(device.read16(Device::VCOM::__address) & Device::VCOM::ACQ::mask);
+	device.advance(TPS65185_Sim<>::__acquisition_us);
+	uint16_t vcom = device.read16(Device::VCOM::__address);
+	CHECK(!(vcom & Device::VCOM::ACQ::mask));
+	CHECK((vcom & Device::VCOM::VCOM_::mask) == 0x123);
+}
+
+/* INT1 and INT2 clear on read; an enabled interrupt drives nINT until then */
+static void testSimInterruptClearOnRead()
+{
+	Device device;
+	device.injectInterrupt(Device::INT1::HOT::mask, Device::INT2::EOC::mask);
+	CHECK(device.interruptPending());
+	CHECK(device.getINT1() == Device::INT1::HOT::mask);
+	CHECK(device.getINT1() == 0);
+	CHECK(device.getINT2() == Device::INT2::EOC::mask);
+	CHECK(device.getINT2() == 0);
+	CHECK(!device.interruptPending());
+}
+
+/* VCOM::PROG stores VCOM to NVM, raises PRGC and powers the rails down */
+static void testSimProgramToStandby()
+{
+	Device device;
+	device.set<Device::ENABLE::ACTIVE>(1);
+	device.advance(24000);
+	CHECK(device.powerGood());
+	device.set<Device::VCOM::VCOM_>(200);
+	device.set<Device::VCOM::PROG>(1);
+	device.advance(TPS65185_Sim<>::__programming_us - 1);
+	CHECK(device.nvmWrites() == 0);
+	device.advance(1);
+	CHECK(device.nvmWrites() == 1);
+	CHECK(device.nvmVCOM() == 200);
+	CHECK(device.getINT1() & Device::INT1::PRGC::mask);
+	CHECK(!(device.read16(Device::VCOM::__address) & Device::VCOM::PROG::mask));
+	CHECK(device.read8(Device::ENABLE::__address) & Device::ENABLE::STANDBY::mask);
+	device.advance(1000000);
+	CHECK(device.getPG() == 0);
+	CHECK(!(device.read8(Device::ENABLE::__address) & Device::ENABLE::STANDBY::mask));
+}
+
+
+
+/*****************************************************************************************************\
+ *                                                                                                   *
+ *                                          REGISTER ACCESS                                          *
+ *                                                                                                   *
+\*****************************************************************************************************/
+
+/* The whole register map is read by one burst and decodes to what single reads report */
+static void testSnapshotOneBurst()
+{
+	Device device;
+	device.setVCOM(0x123);
+	device.setUPSEQ1(0x00);
+	device.injectInterrupt(Device::INT1::HOT::mask, 0);
+	uint32_t transactions = device.busTransactions();
+	Device::Snapshot snapshot;
+	device.readSnapshot(snapshot);
+	CHECK(device.busTransactions() == transactions + 1);
+	CHECK(snapshot.vcom == device.getVCOM());
+	CHECK(snapshot.upseq1 == 0x00);
+	CHECK(snapshot.upseq0 == device.getUPSEQ0());
+	CHECK(snapshot.int1 == Device::INT1::HOT::mask);
+	CHECK(snapshot.revid == device.getREVID());
+	CHECK(device.getINT1() == 0);
+}
+
+/* The static transport behaves as the virtual one, without a vtable pointer */
+static void testStaticTransport()
+{
+	Device device;
+	TPS65185_Sim<TPS65185_Base> sim;
+	TPS65185_Base &base = sim;
+	device.setVCOM(0x155);
+	base.setVCOM(0x155);
+	device.setTMST2(0x34);
+	base.setTMST2(0x34);
+	CHECK(base.getVCOM() == device.getVCOM());
+	CHECK(base.getTMST2() == device.getTMST2());
+	CHECK(base.getREVID() == device.getREVID());
+	CHECK(sim.busTransactions() == device.busTransactions());
+	CHECK(sizeof(Device) < sizeof(TPS65185_Sim<TPS65185_Base>));
+}
+
+/* The name TPS65185 stays free for a user's own class derived from TPS65185_Base */
+class TPS65185 : public TPS65185_Sim<TPS65185_Base>
+{
+};
+
+static void testUserClassName()
+{
+	TPS65185 user;
+	TPS65185_Base &base = user;
+	base.setUPSEQ0(0x1b);
+	CHECK(user.getUPSEQ0() == 0x1b);
+}
+
+
+
+/*****************************************************************************************************\
+ *                                                                                                   *
+ *                                           SHADOW CACHE                                            *
+ *                                                                                                   *
+\*****************************************************************************************************/
+
+/* Configuration registers are served from the shadow once seen */
+static void testCacheServesConfiguration()
+{
+	Device device;
+	device.setCacheEnabled(true);
+	uint8_t upseq0 = device.getUPSEQ0();
+	uint32_t transactions = device.busTransactions();
+	CHECK(device.getUPSEQ0() == upseq0);
+	device.setUPSEQ1(0x00);
+	CHECK(device.getUPSEQ1() == 0x00);
+	CHECK(device.busTransactions() == transactions + 1);
+}
+
+/* An acquisition rewrites both VCOM bytes, so neither may be served from the shadow */
+static void testCacheAcquisitionDropsVCOM()
+{
+	Device device;
+	device.setCacheEnabled(true);
+	device.getVCOM();
+	device.setKickback(0x155);
+	device.set<Device::VCOM::ACQ>(1);
+	device.advance(TPS65185_Sim<>::__acquisition_us);
+	CHECK(device.cachedRead8(Device::VCOM::__address) == 0x55);
+	CHECK(device.get<Device::VCOM::VCOM_>() == 0x155);
+	device.set<Device::VCOM::HiZ>(1);
+	CHECK((device.read16(Device::VCOM::__address) & Device::VCOM::VCOM_::mask) == 0x155);
+}
+
+/* REVID is read-only: a write must not change what getREVID() reports */
+static void testCacheIgnoresReadOnlyWrite()
+{
+	Device device;
+	device.setCacheEnabled(true);
+	uint8_t revid = device.getREVID();
+	device.setREVID(revid ^ 0xff);
+	CHECK(device.getREVID() == revid);
+	CHECK(device.getREVID() == device.read8(Device::REVID::__address));
+}
+
+/* Self-clearing fields read live through get<F>() even with the cache enabled */
+static void testCacheFieldsReadLive()
+{
+	Device device;
+	device.setCacheEnabled(true);
+	device.getTMST1();
+	device.getENABLE();
+	device.set<Device::TMST1::READ_THERM>(1);
+	CHECK(device.get<Device::TMST1::READ_THERM>() == 1);
+	device.advance(TPS65185_Sim<>::__conversion_us);
+	CHECK(device.get<Device::TMST1::CONV_END>() == 1);
+	device.set<Device::ENABLE::ACTIVE>(1);
+	CHECK(device.get<Device::ENABLE::ACTIVE>() == 1);
+	device.advance(24000);
+	CHECK(device.get<Device::ENABLE::ACTIVE>() == 0);
+	
+	/* Other fields of the same registers still come from the shadow */
+	device.getTMST1();
+	device.getENABLE();
+	uint32_t transactions = device.busTransactions();
+	device.get<Device::TMST1::DT>();
+	device.get<Device::ENABLE::VCOM_EN>();
+	CHECK(device.busTransactions() == transactions);
+}
+
+
+
+/*****************************************************************************************************\
+ *                                                                                                   *
+ *                                             SEQUENCER                                             *
+ *                                                                                                   *
+\*****************************************************************************************************/
+
+typedef TPS65185_Sequencer<Device> Sequencer;
+
+static int sequenced = -1;
+
+static void onSequenced(void *context, Sequencer::Result result)
+{
+	(*static_cast<int *>(context))++;
+	sequenced = result;
+}
+
+/* Power-up and power-down settle in the expected state, running the callback once each */
+static void testSequencerPowerUpDown()
+{
+	Device device;
+	Sequencer sequencer(device);
+	int calls = 0;
+	sequencer.powerUp(device.now(), onSequenced, &calls);
+	CHECK(sequencer.getState() == Sequencer::POWERING_UP);
+	while (sequencer.isBusy())
+	{
+		device.advance(1000);
+		sequencer.tick(device.now());
+	}
+	CHECK(calls == 1);
+	CHECK(sequenced == Sequencer::SUCCESS);
+	CHECK(sequencer.getState() == Sequencer::ON);
+	CHECK(device.powerGood());
+	
+	sequencer.powerDown(device.now(), onSequenced, &calls);
+	while (sequencer.isBusy())
+	{
+		device.advance(1000);
+		sequencer.tick(device.now());
+	}
+	CHECK(calls == 2);
+	CHECK(sequencer.getState() == Sequencer::OFF);
+	CHECK(device.getPG() == 0);
+}
+
+/* A PWRGOOD edge completes the power-up without waiting for the next poll */
+static void testSequencerEdge()
+{
+	Device device;
+	Sequencer sequencer(device);
+	sequencer.powerUp(device.now());
+	device.advance(30000);
+	sequencer.onEdge(device.now());
+	CHECK(sequencer.getState() == Sequencer::ON);
+}
+
+
+
+/*****************************************************************************************************\
+ *                                                                                                   *
+ *                                           TIMING MODEL                                            *
+ *                                                                                                   *
+\*****************************************************************************************************/
+
+/* Timelines decoded from UPSEQ/DWNSEQ match the sequences the simulator runs */
+static void testTimingTimelines()
+{
+	TPS65185_Timeline up = TPS65185_Timeline::powerUp(0xe4, 0x55);
+	CHECK(up.strobe[0] == 6000);
+	CHECK(up.rail[TPS65185_Timeline::VNEG] == 6000);
+	CHECK(up.done == 24000);
+	CHECK(TPS65185_Timeline::powerUp(0x00, 0x00, 1000).done == 4000);
+	
+	TPS65185_Timeline down = TPS65185_Timeline::powerDown(0x1e, 0xe0);
+	CHECK(down.strobe[0] == 3000);
+	CHECK(down.strobe[1] == 9000);
+	CHECK(down.strobe[2] == 33000);
+	CHECK(down.done == 81000);
+	
+	/* VPOS never switches on before VNEG */
+	up = TPS65185_Timeline::powerUp(0x0c, 0x00);
+	CHECK(up.rail[TPS65185_Timeline::VPOS] == up.rail[TPS65185_Timeline::VNEG]);
+	
+	Device device;
+	up = TPS65185_Timeline::programmedPowerUp(device);
+	device.set<Device::ENABLE::ACTIVE>(1);
+	device.advance(up.done - 1);
+	CHECK(!device.powerGood());
+	device.advance(1);
+	CHECK(device.powerGood());
+}
+
+/* The sequencer does not read PG before the end of the sequence predicted from UPSEQ */
+static void testSequencerWaitsForPrediction()
+{
+	Device device;
+	Sequencer sequencer(device);
+	sequencer.powerUp(device.now());
+	uint32_t transactions = device.busTransactions();
+	while (int32_t(device.now() + 1000 - sequencer.nextPoll()) < 0)
+	{
+		device.advance(1000);
+		sequencer.tick(device.now());
+	}
+	CHECK(device.busTransactions() == transactions);
+	CHECK(device.now() >= 18000);
+}
+
+
+
+/*****************************************************************************************************\
+ *                                                                                                   *
+ *                                             OPTIMIZER                                             *
+ *                                                                                                   *
+\*****************************************************************************************************/
+
+/* The shortest sequence meets every constraint and gets longer only when settling demands it */
+static void testOptimizerSolve()
+{
+	TPS65185_Optimizer::Constraints constraints;
+	TPS65185_Optimizer::Result result = TPS65185_Optimizer::solve(constraints);
+	CHECK(result.found);
+	CHECK(result.timeline.done == 6000);
+	CHECK(TPS65185_Optimizer::satisfies(result.timeline, constraints));
+	
+	constraints.settle_us[TPS65185_Timeline::VNEG] = 7000;
+	result = TPS65185_Optimizer::solve(constraints);
+	CHECK(result.found);
+	CHECK(result.timeline.done == 12000);
+	TPS65185_Timeline timeline = TPS65185_Timeline::powerUp(result.upseq0, result.upseq1);
+	CHECK(timeline.done == result.timeline.done);
+	CHECK(TPS65185_Optimizer::satisfies(timeline, constraints));
+}
+
+
+
+/*****************************************************************************************************\
+ *                                                                                                   *
+ *                                            INTERRUPTS                                             *
+ *                                                                                                   *
+\*****************************************************************************************************/
+
+typedef TPS65185_Interrupts<Device> Interrupts;
+
+static uint16_t dispatched = 0;
+
+static void onEvents(void *context, uint16_t events)
+{
+	(void)context;
+	dispatched |= events;
+}
+
+/* INT_EN1/INT_EN2 follow the subscriptions, and only pending subscribed events are dispatched */
+static void testInterruptsDispatch()
+{
+	Device device;
+	Interrupts interrupts(device);
+	CHECK(interrupts.subscribe(Interrupts::EOC | Interrupts::TSD, onEvents));
+	CHECK(device.getINT_EN1() == Device::INT1::TSD::mask);
+	CHECK(device.getINT_EN2() == Device::INT2::EOC::mask);
+	
+	dispatched = 0;
+	device.set<Device::TMST1::READ_THERM>(1);
+	device.advance(TPS65185_Sim<>::__conversion_us);
+	CHECK(device.interruptPending());
+	interrupts.onInterrupt();
+	CHECK(dispatched == Interrupts::EOC);
+	CHECK(!device.interruptPending());
+	
+	interrupts.unsubscribe(onEvents);
+	CHECK(device.getINT_EN1() == 0);
+	CHECK(device.getINT_EN2() == 0);
+}
+
+static Interrupts *dispatcher = 0;
+static int unsubscribing = 0;
+static int later = 0;
+static int removed = 0;
+
+static void onLater(void *context, uint16_t events)
+{
+	(void)context;
+	(void)events;
+	later++;
+}
+
+static void onRemoved(void *context, uint16_t events)
+{
+	(void)context;
+	(void)events;
+	removed++;
+}
+
+/* Removes itself and onRemoved while being dispatched */
+static void onUnsubscribing(void *context, uint16_t events)
+{
+	(void)context;
+	(void)events;
+	unsubscribing++;
+	dispatcher->unsubscribe(onUnsubscribing);
+	dispatcher->unsubscribe(onRemoved);
+}
+
+/* A handler unsubscribing during dispatch does not make the dispatch skip or call the wrong handlers */
+static void testInterruptsUnsubscribeInHandler()
+{
+	Device device;
+	Interrupts interrupts(device);
+	dispatcher = &interrupts;
+	unsubscribing = later = removed = 0;
+	interrupts.subscribe(Interrupts::HOT, onUnsubscribing);
+	interrupts.subscribe(Interrupts::HOT, onLater);
+	interrupts.subscribe(Interrupts::HOT | Interrupts::TSD, onRemoved);
+	interrupts.dispatch(Interrupts::HOT);
+	CHECK(unsubscribing == 1);
+	CHECK(later == 1);
+	CHECK(removed == 0);
+	CHECK(interrupts.enabledEvents() == Interrupts::HOT);
+	CHECK(device.getINT_EN1() == Device::INT1::HOT::mask);
+	interrupts.dispatch(Interrupts::HOT);
+	CHECK(unsubscribing == 1);
+	CHECK(later == 2);
+}
+
+/* INT1 and INT2 are read, and cleared, by a single 16 bit transfer */
+static void testInterruptsSingleTransfer()
+{
+	Device device;
+	device.injectInterrupt(Device::INT1::HOT::mask, Device::INT2::EOC::mask);
+	uint32_t transactions = device.busTransactions();
+	Device::Interrupts interrupts = device.getInterrupts();
+	CHECK(device.busTransactions() == transactions + 1);
+	CHECK(interrupts.has<Device::INT1::HOT>());
+	CHECK(interrupts.has<Device::INT2::EOC>());
+	CHECK(!interrupts.has<Device::INT1::PRGC>());
+	CHECK(interrupts.int1() == Device::INT1::HOT::mask);
+	CHECK(interrupts.int2() == Device::INT2::EOC::mask);
+	CHECK(!device.interruptPending());
+	
+	device.injectInterrupt(Device::INT1::ACQC::mask, Device::INT2::VCOMF::mask);
+	CHECK(device.getInterrupts().value == (Device::INT1::ACQC::mask | uint16_t(Device::INT2::VCOMF::mask) << 8));
+	CHECK(device.getInterrupts().value == 0);
+}
+
+
+
+/*****************************************************************************************************\
+ *                                                                                                   *
+ *                                            TEMPERATURE                                            *
+ *                                                                                                   *
+\*****************************************************************************************************/
+
+typedef TPS65185_Temperature<Device> Temperature;
+
+/* A reading is taken without blocking, served with its age and dropped once stale */
+static void testTemperatureCachedReading()
+{
+	Device device;
+	Temperature temperature(device, 5000000);
+	int celsius = 0;
+	device.setTemperature(-5);
+	CHECK(!temperature.get(device.now(), celsius));
+	device.advance(500);
+	temperature.tick(device.now());
+	CHECK(temperature.isConverting());
+	device.advance(500);
+	temperature.tick(device.now());
+	CHECK(!temperature.isConverting());
+	CHECK(temperature.get(device.now(), celsius));
+	CHECK(celsius == -5);
+	device.advance(6000000);
+	CHECK(!temperature.get(device.now(), celsius));
+	
+	/* With EOC subscribed the result is fetched by one read */
+	Interrupts interrupts(device);
+	interrupts.subscribe(Interrupts::EOC, Temperature::onEOC, &temperature);
+	device.setTemperature(40);
+	device.advance(1000);
+	CHECK(device.interruptPending());
+	interrupts.onInterrupt();
+	uint32_t transactions = device.busTransactions();
+	temperature.tick(device.now());
+	CHECK(device.busTransactions() == transactions + 1);
+	CHECK(temperature.get(device.now(), celsius));
+	CHECK(celsius == 40);
+}
+
+/* In DTX mode the reading stays valid until the device reports a change */
+static void testTemperatureDTX()
+{
+	Device device;
+	device.setCacheEnabled(true);
+	Temperature temperature(device);
+	Interrupts interrupts(device);
+	interrupts.subscribe(Interrupts::DTX, Temperature::onDTX, &temperature);
+	int celsius = 0;
+	device.setTemperature(25);
+	temperature.get(device.now(), celsius);
+	device.advance(1000);
+	temperature.tick(device.now());
+	CHECK(temperature.get(device.now(), celsius));
+	CHECK(celsius == 25);
+	
+	temperature.setDTXMode(true, device.now(), 60000000);
+	uint32_t transactions = device.busTransactions();
+	for (int i = 0; i < 100; i++)
+	{
+		device.advance(60000000);
+		temperature.tick(device.now());
+		if (device.interruptPending())
+			interrupts.onInterrupt();
+		temperature.tick(device.now());
+		CHECK(temperature.get(device.now(), celsius));
+	}
+	CHECK(device.busTransactions() - transactions <= 2 * 100);
+	CHECK(temperature.changes() == 1);
+	
+	device.setTemperature(29);
+	device.advance(60000000);
+	temperature.tick(device.now());
+	device.advance(1000);
+	CHECK(device.interruptPending());
+	interrupts.onInterrupt();
+	temperature.tick(device.now());
+	CHECK(temperature.get(device.now(), celsius));
+	CHECK(celsius == 29);
+	CHECK(temperature.changes() == 2);
+}
+
+
+
+/*****************************************************************************************************\
+ *                                                                                                   *
+ *                                             WAVEFORM                                              *
+ *                                                                                                   *
+\*****************************************************************************************************/
+
+static void testWaveformBands()
+{
+	static const int boundary[] = { 0, 10, 25, 50 };
+	TPS65185_Waveform waveform(boundary, 4);
+	CHECK(waveform.isValid());
+	CHECK(waveform.band(uint8_t(-5)) == 0);
+	CHECK(waveform.band(0) == 1);
+	CHECK(waveform.band(24) == 2);
+	CHECK(waveform.band(25) == 3);
+	CHECK(waveform.band(85) == 4);
+	
+	Device device;
+	CHECK(waveform.program(device));
+	CHECK(device.getTMST2() == waveform.tmst2());
+}
+
+/* No boundaries or unsorted ones are rejected instead of building a wrong table */
+static void testWaveformRejectsBadBoundaries()
+{
+	static const int unsorted[] = { 10, 0, 25 };
+	TPS65185_Waveform none(unsorted, 0);
+	TPS65185_Waveform shuffled(unsorted, 3);
+	CHECK(!none.isValid());
+	CHECK(!shuffled.isValid());
+	CHECK(shuffled.band(30) == 0);
+	
+	Device device;
+	uint8_t tmst2 = device.getTMST2();
+	CHECK(!shuffled.program(device));
+	CHECK(device.getTMST2() == tmst2);
+}
+
+
+
+/*****************************************************************************************************\
+ *                                                                                                   *
+ *                                            CALIBRATION                                            *
+ *                                                                                                   *
+\*****************************************************************************************************/
+
+typedef TPS65185_Calibration<Device> Calibration;
+
+/* A batch takes one acquisition per averaging setting, each completed by polling or by ACQC */
+static void testCalibrationBatch()
+{
+	Device device;
+	device.setCacheEnabled(true);
+	Calibration calibration(device);
+	device.setKickback(150);
+	uint8_t avg[3] = { 0, 1, 3 };
+	CHECK(calibration.startBatch(device.now(), avg, 3));
+	while (calibration.isBusy())
+	{
+		device.advance(500);
+		calibration.tick(device.now());
+		if (device.now() == 2000)
+			device.setKickback(160);
+	}
+	const Calibration::Result &result = calibration.getResult();
+	CHECK(result.count == 3);
+	CHECK(result.sample[0] == 150);
+	CHECK(result.min == 150);
+	CHECK(result.max == 160);
+	CHECK(result.spread() == 10);
+	
+	Interrupts interrupts(device);
+	interrupts.subscribe(Interrupts::ACQC, Calibration::onACQC, &calibration);
+	calibration.start(device.now(), Device::VCOM::AVG::AVG1x, 2);
+	while (calibration.isBusy())
+	{
+		device.advance(4000);
+		if (device.interruptPending())
+			interrupts.onInterrupt();
+		calibration.tick(device.now());
+	}
+	CHECK(calibration.getResult().mean == 160);
+}
+
+/* Simulator whose VCOM reads report the bits in Stuck as set, e.g. an ACQ that never clears */
+template <uint16_t Stuck>
+class StuckVCOM : public TPS65185_Sim<>
+{
+public:
+	uint16_t read16(uint16_t address, uint16_t n=16)
+	{
+		uint16_t value = TPS65185_Sim<>::read16(address, n);
+		return address == R::VCOM::__address ? value | Stuck : value;
+	}
+};
+
+typedef TPS65185_Calibration<TPS65185_Device<StuckVCOM<Device::VCOM::ACQ::mask> > > StuckCalibration;
+
+static int calibrated = -1;
+
+static void onCalibrated(void *context, const StuckCalibration::Result &result)
+{
+	(void)context;
+	calibrated = result.status;
+}
+
+/* An acquisition that never ends times out, reports it and restores HiZ/AVG */
+static void testCalibrationTimeout()
+{
+	TPS65185_Device<StuckVCOM<Device::VCOM::ACQ::mask> > device;
+	StuckCalibration calibration(device, 1000, 10000);
+	uint16_t vcom = device.getVCOM() & ~Device::VCOM::ACQ::mask;
+	calibrated = -1;
+	CHECK(calibration.start(device.now(), Device::VCOM::AVG::AVG1x, 2, onCalibrated));
+	for (int i = 0; i < 100 && calibration.isBusy(); i++)
+	{
+		device.advance(1000);
+		calibration.tick(device.now());
+	}
+	CHECK(!calibration.isBusy());
+	CHECK(device.now() <= 11000);
+	CHECK(calibrated == StuckCalibration::TIMEOUT);
+	CHECK(calibration.getResult().count == 0);
+	CHECK((device.getVCOM() & ~Device::VCOM::ACQ::mask) == vcom);
+	CHECK(!device.get<Device::VCOM::HiZ>());
+}
+
+
+
+/*****************************************************************************************************\
+ *                                                                                                   *
+ *                                            PROGRAMMER                                             *
+ *                                                                                                   *
+\*****************************************************************************************************/
+
+/* Set VCOM, then persist it: programs although the register already holds the code */
+static void testProgrammerPersistsSetVCOM()
+{
+	Device device;
+	TPS65185_Programmer<Device> programmer(device);
+	device.set<Device::VCOM::VCOM_>(200);
+	CHECK(programmer.program(0, 200) == TPS65185_Programmer<Device>::STARTED);
+	device.advance(TPS65185_Sim<>::__programming_us);
+	programmer.tick(TPS65185_Sim<>::__programming_us);
+	CHECK(!programmer.isBusy());
+	CHECK(device.nvmVCOM() == 200);
+	CHECK(device.nvmWrites() == 1);
+	CHECK(programmer.isStoredKnown());
+	CHECK(programmer.program(100000000, 200) == TPS65185_Programmer<Device>::UNCHANGED);
+}
+
+/* After load() an unchanged code is not programmed, and programming is rate-limited */
+static void testProgrammerSkipsAndRateLimits()
+{
+	Device device;
+	TPS65185_Programmer<Device> programmer(device, 1000000);
+	programmer.load();
+	CHECK(programmer.program(0, device.nvmVCOM()) == TPS65185_Programmer<Device>::UNCHANGED);
+	CHECK(programmer.program(0, 150) == TPS65185_Programmer<Device>::STARTED);
+	CHECK(programmer.program(0, 160) == TPS65185_Programmer<Device>::BUSY);
+	device.advance(TPS65185_Sim<>::__programming_us);
+	programmer.tick(TPS65185_Sim<>::__programming_us);
+	CHECK(programmer.program(500000, 160) == TPS65185_Programmer<Device>::RATE_LIMITED);
+	CHECK(programmer.program(1000000, 160) == TPS65185_Programmer<Device>::STARTED);
+	CHECK(device.nvmWrites() == 1);
+}
+
+/* PROG still set at the deadline: report TIMEOUT and write nothing, the device stays in STANDBY */
+static void testProgrammerTimeout()
+{
+	typedef TPS65185_Device<StuckVCOM<Device::VCOM::PROG::mask> > StuckDevice;
+	typedef TPS65185_Programmer<StuckDevice> StuckProgrammer;
+	StuckDevice device;
+	device.set<Device::ENABLE::ACTIVE>(1);
+	device.advance(24000);
+	StuckProgrammer programmer(device, 1000000, 100000, 5000);
+	CHECK(programmer.program(device.now(), 150) == StuckProgrammer::STARTED);
+	device.setUPSEQ1(0xff);
+	uint32_t transactions = device.busTransactions();
+	int polls = 0;
+	while (programmer.isBusy())
+	{
+		device.advance(5000);
+		programmer.tick(device.now());
+		polls++;
+	}
+	CHECK(device.busTransactions() == transactions + polls);
+	CHECK(device.peek(Device::UPSEQ1::__address) == 0xff);
+	CHECK(!device.powerGood());
+	CHECK(!programmer.isStoredKnown());
+}
+
+/* The configuration lost to the implicit STANDBY is written back after programming */
+static void testProgrammerRestoresConfiguration()
+{
+	Device device;
+	device.setUPSEQ1(0x00);
+	TPS65185_Programmer<Device> programmer(device);
+	CHECK(programmer.program(0, 150) == TPS65185_Programmer<Device>::STARTED);
+	device.write(Device::UPSEQ1::__address, uint8_t(0xff));
+	device.advance(TPS65185_Sim<>::__programming_us);
+	programmer.tick(TPS65185_Sim<>::__programming_us);
+	CHECK(device.getUPSEQ1() == 0x00);
+	CHECK(device.get<Device::VCOM::VCOM_>() == 150);
+}
+
+
+
+/*****************************************************************************************************\
+ *                                                                                                   *
+ *                                               UNITS                                               *
+ *                                                                                                   *
+\*****************************************************************************************************/
+
+/* Compile-time codes agree with the run-time conversions and round as the datasheet tables */
+static void testUnitsConversions()
+{
+	CHECK(TPS65185_VCOMCode<-1250>::value == 0x7d);
+	CHECK(TPS65185_VCOMMillivolts<0x1ff>::value == -5110);
+	CHECK(TPS65185_Units::vcomCode(-1254) == 125);
+	CHECK(TPS65185_Units::vcomCode(-1256) == 126);
+	CHECK(TPS65185_VSETCode<14750>::value == 4);
+	CHECK(TPS65185_VSETMillivolts<6>::value == 15250);
+	CHECK(TPS65185_ColdCode<0>::value == 7);
+	CHECK(TPS65185_HotCelsius<8>::value == 50);
+	CHECK(TPS65185_Units::hotCode(100) == 15);
+	CHECK(TPS65185_TempCode<-10>::value == 0xf6);
+	CHECK(TPS65185_DTCode<3>::value == 1);
+	CHECK(TPS65185_UDLYCode<9>::value == 2);
+	CHECK(TPS65185_DDLYCode<24>::value == 2);
+	CHECK(TPS65185_DDLYMilliseconds<3>::value == 48);
+}
+
+
+
+/*****************************************************************************************************\
+ *                                                                                                   *
+ *                                               FLEET                                               *
+ *                                                                                                   *
+\*****************************************************************************************************/
+
+typedef TPS65185_Fleet<Device, 8> Fleet;
+
+static int selects = 0;
+
+static void countSelect(void *context, uint8_t segment)
+{
+	(void)context;
+	(void)segment;
+	selects++;
+}
+
+static void setSequence(void *context, Device &device)
+{
+	(void)context;
+	device.setUPSEQ0(0xe4);
+	device.setUPSEQ1(0x00);
+	device.setDWNSEQ0(0x1b);
+	device.setDWNSEQ1(0x00);
+}
+
+static void configureSequence(void *context, Device &device, Fleet::Batch &batch)
+{
+	(void)context;
+	(void)device;
+	batch.write(Device::UPSEQ0::__address, uint8_t(0xe4));
+	batch.write(Device::UPSEQ1::__address, uint8_t(0x00));
+	batch.write(Device::DWNSEQ0::__address, uint8_t(0x1b));
+	batch.write(Device::DWNSEQ1::__address, uint8_t(0x00));
+}
+
+/* Advance every device and the fleet until it has settled; returns the time */
+static uint32_t runFleet(Fleet &fleet, Device *devices, int count, uint32_t now)
+{
+	while (fleet.isBusy())
+	{
+		uint32_t next = fleet.nextPoll();
+		for (int i = 0; i < count; i++)
+			devices[i].advance(next - now);
+		now = next;
+		fleet.tick(now);
+		int drawing = 0;
+		for (int i = 0; i < fleet.size(); i++)
+			drawing += fleet.getState(i) == Fleet::Sequencer::POWERING_UP;
+		CHECK(drawing <= 3);
+	}
+	return now;
+}
+
+/* 8 devices of inrush 100 on 2 segments within a limit of 300: 3 waves */
+static void testFleetPowersUpInWaves()
+{
+	static Device devices[8];
+	Fleet fleet(300, countSelect);
+	for (int i = 0; i < 8; i++)
+		CHECK(fleet.add(devices[i], i % 2, 100));
+	
+	selects = 0;
+	fleet.forEach(setSequence);
+	CHECK(selects == 2);
+	
+	fleet.powerUp(0);
+	uint32_t now = runFleet(fleet, devices, 8, 0);
+	CHECK(fleet.getWaves() == 3);
+	for (int i = 0; i < 8; i++)
+		CHECK(devices[i].powerGood());
+	
+	fleet.powerDown(now);
+	runFleet(fleet, devices, 8, now);
+	for (int i = 0; i < 8; i++)
+		CHECK(devices[i].getPG() == 0);
+}
+
+/* configure() commits the writes of each device as one burst, selecting each segment once */
+static void testFleetConfigureBatches()
+{
+	static Device devices[4];
+	Fleet fleet(300, countSelect);
+	for (int i = 0; i < 4; i++)
+		CHECK(fleet.add(devices[i], i % 2, 100));
+	
+	selects = 0;
+	uint32_t transactions = devices[0].busTransactions();
+	fleet.configure(configureSequence);
+	CHECK(selects == 2);
+	CHECK(devices[0].busTransactions() == transactions + 1);
+	CHECK(devices[3].getUPSEQ0() == 0xe4);
+}
+
+
+
+/*****************************************************************************************************\
+ *                                                                                                   *
+ *                                               BATCH                                               *
+ *                                                                                                   *
+\*****************************************************************************************************/
+
+/* Queued writes are merged per register and committed as one burst per run of adjacent registers */
+static void testBatchCommit()
+{
+	Device device;
+	device.setCacheEnabled(true);
+	TPS65185_Batch<Device> batch(device);
+	batch.write(Device::UPSEQ0::__address, uint8_t(0x1b));
+	batch.write(Device::UPSEQ1::__address, uint8_t(0xaa));
+	batch.write(Device::DWNSEQ0::__address, uint8_t(0x1b));
+	batch.set<Device::DWNSEQ1::DFCTR>(1);
+	batch.write(Device::TMST2::__address, uint8_t(0x34));
+	batch.write(Device::INT_EN1::__address, uint8_t(0x11));
+	batch.write(Device::INT_EN2::__address, uint8_t(0x22));
+	batch.write(Device::INT_EN1::__address, uint8_t(0x13));
+	batch.set<Device::VCOM::VCOM_>(0x155);
+	uint32_t transactions = device.busTransactions();
+	CHECK(batch.commit() == 3);
+	CHECK(device.busTransactions() == transactions + 3);
+	CHECK(batch.isEmpty());
+	CHECK(device.peek(Device::UPSEQ0::__address) == 0x1b);
+	CHECK(device.peek(Device::UPSEQ1::__address) == 0xaa);
+	CHECK(device.peek(Device::DWNSEQ0::__address) == 0x1b);
+	CHECK(device.get<Device::DWNSEQ1::DFCTR>() == 1);
+	CHECK(device.peek(Device::TMST2::__address) == 0x34);
+	CHECK(device.peek(Device::INT_EN1::__address) == 0x13);
+	CHECK(device.peek(Device::INT_EN2::__address) == 0x22);
+	CHECK(device.get<Device::VCOM::VCOM_>() == 0x155);
+}
+
+/* Writes past the register file are refused instead of overrunning the batch */
+static void testBatchRejectsBadAddress()
+{
+	Device device;
+	TPS65185_Batch<Device> batch(device);
+	CHECK(!batch.write(Device::__registers, uint8_t(0x12)));
+	CHECK(!batch.write(1000, uint8_t(0x12)));
+	CHECK(!batch.write(Device::REVID::__address, uint16_t(0x1234)));
+	CHECK(batch.isEmpty());
+	CHECK(!batch.isPending(Device::__registers));
+	CHECK(batch.write(Device::VCOM::__address, uint16_t(0x0123)));
+	CHECK(batch.commit() == 1);
+}
+
+
+
+/*****************************************************************************************************\
+ *                                                                                                   *
+ *                                              I2C-DEV                                              *
+ *                                                                                                   *
+\*****************************************************************************************************/
+
+typedef TPS65185_Device<TPS65185_I2CDev<> > I2CDevice;
+
+/* In-process fake of the I2C_RDWR ioctl: a TPS65185_Sim behind address 0x68 */
+static TPS65185_Sim<> bus;
+static int messages = 0;
+
+static int fakeIoctl(int fd, unsigned long request, void *argument)
+{
+	(void)fd;
+	if (request != I2C_RDWR)
+	{
+		errno = ENOTTY;
+		return -1;
+	}
+	struct i2c_rdwr_ioctl_data *data = static_cast<struct i2c_rdwr_ioctl_data *>(argument);
+	uint8_t pointer = 0;
+	for (unsigned i = 0; i < data->nmsgs; i++)
+	{
+		struct i2c_msg &msg = data->msgs[i];
+		messages++;
+		if (msg.addr != TPS65185_I2CDev<>::__address)
+		{
+			errno = ENXIO;
+			return -1;
+		}
+		if (msg.flags & I2C_M_RD)
+			bus.readBurst(pointer, msg.buf, msg.len);
+		else
+		{
+			pointer = msg.buf[0];
+			bus.writeBurst(pointer, msg.buf + 1, msg.len - 1);
+		}
+	}
+	return data->nmsgs;
+}
+
+/* Every access is one syscall; a batch of writes is one syscall at commit */
+static void testI2CDevSyscalls()
+{
+	I2CDevice device;
+	device.attach(3);
+	device.setIoctl(fakeIoctl);
+	bus.reset();
+	messages = 0;
+	CHECK(device.getREVID() == bus.peek(Device::REVID::__address));
+	CHECK(device.syscallCount() == 1);
+	CHECK(messages == 2);
+	device.setVCOM(0x0123);
+	CHECK(bus.peek(Device::VCOM::__address) == 0x23);
+	CHECK(bus.peek(Device::VCOM::__address + 1) == 0x01);
+	CHECK(device.syscallCount() == 2);
+	
+	device.beginBatch();
+	device.setUPSEQ0(0x1b);
+	device.setUPSEQ1(0x00);
+	device.setTMST2(0x12);
+	CHECK(device.syscallCount() == 2);
+	CHECK(device.commitBatch());
+	CHECK(device.syscallCount() == 3);
+	CHECK(bus.peek(Device::UPSEQ0::__address) == 0x1b);
+	CHECK(bus.peek(Device::TMST2::__address) == 0x12);
+	
+	I2CDevice::Snapshot snapshot;
+	device.readSnapshot(snapshot);
+	CHECK(device.syscallCount() == 4);
+	CHECK(snapshot.upseq0 == 0x1b);
+	CHECK(device.errorCount() == 0);
+}
+
+/* A bus passed in stays open; one opened by the transport closes with it */
+static void testI2CDevOwnership()
+{
+	int fd = ::open("/dev/null", O_RDWR);
+	{
+		I2CDevice device;
+		device.attach(fd);
+	}
+	CHECK(fcntl(fd, F_GETFD) != -1);
+	::close(fd);
+	
+	int opened = -1;
+	{
+		I2CDevice device;
+		CHECK(device.open("/dev/null"));
+		opened = device.getFd();
+		CHECK(opened >= 0);
+	}
+	CHECK(fcntl(opened, F_GETFD) == -1);
+	
+	I2CDevice missing;
+	CHECK(!missing.open("/nonexistent/i2c-9"));
+	CHECK(missing.lastError() == ENOENT);
+}
+
+static int failingIoctl(int fd, unsigned long request, void *argument)
+{
+	(void)fd;
+	(void)request;
+	(void)argument;
+	errno = EIO;
+	return -1;
+}
+
+/* A failed read is reported and not taken into the shadow cache */
+static void testI2CDevFailedReadNotCached()
+{
+	I2CDevice device;
+	device.attach(3);
+	device.setCacheEnabled(true);
+	bus.reset();
+	device.setIoctl(failingIoctl);
+	CHECK(device.getUPSEQ0() == 0);
+	CHECK(device.transferFailed());
+	CHECK(device.lastError() == EIO);
+	I2CDevice::Snapshot snapshot;
+	device.readSnapshot(snapshot);
+	
+	device.setIoctl(fakeIoctl);
+	uint32_t syscalls = device.syscallCount();
+	CHECK(device.getUPSEQ0() == bus.peek(Device::UPSEQ0::__address));
+	CHECK(!device.transferFailed());
+	CHECK(device.syscallCount() == syscalls + 1);
+	CHECK(device.getVCOM() == (bus.peek(Device::VCOM::__address) | (bus.peek(Device::VCOM::__address + 1) << 8)));
+}
+
+
+
+/*****************************************************************************************************\
+ *                                                                                                   *
+ *                                               TRACE                                               *
+ *                                                                                                   *
+\*****************************************************************************************************/
+
+/* Clock advancing 3 ticks per call, so every transaction takes 3 ticks */
+struct TestClock
+{
+	static uint32_t ticks;
+	
+	static uint32_t now()
+	{
+		return ticks += 3;
+	}
+};
+
+uint32_t TestClock::ticks = 0;
+
+typedef TPS65185_Device<TPS65185_Traced<TPS65185_Sim<>, TestClock, 8> > TracedDevice;
+
+/* Transactions are counted per address; dump() returns the latest, at most Depth - 1 */
+static void testTraceRecords()
+{
+	TracedDevice device;
+	CHECK(device.getREVID() == 0x45);
+	device.setVCOM(0x123);
+	uint8_t out[256];
+	uint16_t size = device.dump(out, sizeof out);
+#ifdef TPS65185_TRACE
+	const TPS65185_Trace::Stats &revid = device.stats(TracedDevice::REVID::__address);
+	CHECK(revid.calls == 1);
+	CHECK(revid.bytes == 1);
+	CHECK(revid.max == 3);
+	CHECK(revid.histogram[TPS65185_Trace::bucket(3)] == 1);
+	CHECK(device.stats(TracedDevice::VCOM::__address).bytes == 2);
+	CHECK(size == TPS65185_Trace::__header + 2 * TPS65185_Trace::__record);
+	CHECK(out[0] == 'T' && out[3] == '5');
+	CHECK(out[6] == 2);
+	CHECK(out[8 + 6] == TPS65185_Trace::READ8);
+	CHECK(out[8 + 7] == TracedDevice::REVID::__address);
+	CHECK(out[20 + 6] == TPS65185_Trace::WRITE16);
+	CHECK(out[20 + 10] == 0x23 && out[20 + 11] == 0x01);
+	
+	for (int i = 0; i < 20; i++)
+		device.getPG();
+	device.dump(out, sizeof out);
+	CHECK(out[6] == 8 - 1);
+	CHECK(device.transactions() == 22);
+#else
+	/* Without TPS65185_TRACE the decorator is the transport itself */
+	CHECK(size == TPS65185_Trace::__header);
+	CHECK(out[6] == 0);
+	CHECK(sizeof(TracedDevice) == sizeof(Device));
+#endif
+}
+
+
+
+/*****************************************************************************************************\
+ *                                                                                                   *
+ *                                              SHARED                                               *
+ *                                                                                                   *
+\*****************************************************************************************************/
+
+typedef TPS65185_Shared<Device> Shared;
+
+/* Move simulated time on under the bus lock; returns the new time */
+static uint32_t advance(Shared &shared, uint32_t us)
+{
+	Shared::Access access(shared);
+	access.device().advance(us);
+	return access.device().now();
+}
+
+/* Display thread: power cycles through a sequencer on the shared device */
+static void *displayThread(void *argument)
+{
+	Shared &shared = *static_cast<Shared *>(argument);
+	TPS65185_Sequencer<Shared> sequencer(shared);
+	long failed = 0;
+	for (int cycle = 0; cycle < 20; cycle++)
+	{
+		sequencer.powerUp(advance(shared, 0));
+		while (sequencer.isBusy())
+			sequencer.tick(advance(shared, 500));
+		failed += sequencer.getState() != TPS65185_Sequencer<Shared>::ON;
+		sequencer.powerDown(advance(shared, 0));
+		while (sequencer.isBusy())
+			sequencer.tick(advance(shared, 500));
+		failed += sequencer.getState() != TPS65185_Sequencer<Shared>::OFF;
+	}
+	return (void *)failed;
+}
+
+/* Thermal monitor: temperature conversions on the shared device */
+static void *thermalThread(void *argument)
+{
+	Shared &shared = *static_cast<Shared *>(argument);
+	TPS65185_Temperature<Shared> temperature(shared, 0);
+	long wrong = 0;
+	for (int reading = 0; reading < 100; reading++)
+	{
+		int celsius = 0;
+		uint32_t now = advance(shared, 0);
+		while (!temperature.get(now, celsius))
+		{
+			now = advance(shared, 200);
+			temperature.tick(now);
+		}
+		wrong += celsius != 30;
+	}
+	return (void *)wrong;
+}
+
+/* Calibration tool: kick-back measurements on the shared device */
+static void *calibrationThread(void *argument)
+{
+	Shared &shared = *static_cast<Shared *>(argument);
+	TPS65185_Calibration<Shared> calibration(shared);
+	static const uint8_t avg[] = { 0, 0, 0 };
+	long wrong = 0;
+	for (int batch = 0; batch < 10; batch++)
+	{
+		calibration.startBatch(advance(shared, 0), avg, 3);
+		while (calibration.isBusy())
+			calibration.tick(advance(shared, 500));
+		wrong += calibration.getResult().mean != 0x123;
+	}
+	return (void *)wrong;
+}
+
+/* The components instantiate over TPS65185_Shared and run in parallel threads */
+static void testSharedThreads()
+{
+	Device device;
+	device.setCacheEnabled(true);
+	device.setTemperature(30);
+	device.setKickback(0x123);
+	Shared shared(device);
+	
+	pthread_t display, thermal, calibration;
+	pthread_create(&display, 0, displayThread, &shared);
+	pthread_create(&thermal, 0, thermalThread, &shared);
+	pthread_create(&calibration, 0, calibrationThread, &shared);
+	void *failed, *wrong_temperature, *wrong_kickback;
+	pthread_join(display, &failed);
+	pthread_join(thermal, &wrong_temperature);
+	pthread_join(calibration, &wrong_kickback);
+	CHECK(failed == 0);
+	CHECK(wrong_temperature == 0);
+	CHECK(wrong_kickback == 0);
+	
+	Shared::Image image;
+	shared.view(image);
+	CHECK(image.regs[Device::TMST_VALUE::__address] == 30);
+}
+
+/* Self-clearing fields read live, and the image follows what was seen */
+static void testSharedFieldsAndImage()
+{
+	Device device;
+	device.setCacheEnabled(true);
+	Shared shared(device);
+	shared.set<Shared::ENABLE::ACTIVE>(1);
+	CHECK(shared.get<Shared::ENABLE::ACTIVE>() == 1);
+	advance(shared, 24000);
+	CHECK(shared.get<Shared::ENABLE::ACTIVE>() == 0);
+	
+	shared.set<Shared::VCOM::VCOM_>(0x155);
+	shared.refresh();
+	Shared::Image image;
+	shared.view(image);
+	CHECK(image.regs[Device::VCOM::__address] == 0x55);
+	CHECK(image.regs[Device::PG::__address] == device.getPG());
+	CHECK(!(image.valid & (1UL << Device::INT1::__address)));
+	
+	/* A register without a shadow is modified as the core does it, keeping the bits read */
+	uint8_t pg = device.getPG();
+	CHECK(pg != 0);
+	shared.set<Shared::PG::VB_PG>(0);
+	shared.view(image);
+	CHECK(image.regs[Device::PG::__address] == (pg & ~Device::PG::VB_PG::mask));
+}
+
+
+
+/*****************************************************************************************************\
+ *                                                                                                   *
+ *                                        POWER-GOOD WATCHDOG                                        *
+ *                                                                                                   *
+\*****************************************************************************************************/
+
+typedef TPS65185_PowerGood<Device> PowerGood;
+
+static uint8_t lost = 0;
+static uint32_t lostAt = 0;
+
+static void onPowerGood(void *context, uint8_t pg, uint8_t lostRails, uint32_t time)
+{
+	(void)context;
+	(void)pg;
+	lost = lostRails;
+	lostAt = time;
+}
+
+/* Polling backs off while PG is stable and a lost rail is still caught within max_us */
+static void testPowerGoodAdaptivePolling()
+{
+	Device device;
+	device.set<Device::ENABLE::ACTIVE>(1);
+	device.advance(30000);
+	device.setINT_EN2(0);
+	PowerGood watchdog(device);
+	watchdog.setCallback(onPowerGood);
+	watchdog.start(device.now());
+	watchdog.arm(true);
+	CHECK(!watchdog.isInterruptDriven());
+	CHECK(watchdog.state() == PowerGood::__rails);
+	for (int i = 0; i < 10000; i++)
+	{
+		device.advance(1000);
+		watchdog.tick(device.now());
+	}
+	CHECK(watchdog.polls() < 25);
+	
+	lost = 0;
+	device.injectInterrupt(Device::INT1::UVLO::mask, 0);
+	uint32_t fault = device.now();
+	while (!lost)
+	{
+		device.advance(1000);
+		watchdog.tick(device.now());
+	}
+	CHECK(lost == PowerGood::__rails);
+	CHECK(lostAt - fault <= 1000000);
+	CHECK(watchdog.faults() == 1);
+	CHECK(watchdog.lastFault() == lostAt);
+}
+
+/* With every UV interrupt enabled polling is only a heartbeat and onUV() triggers the read */
+static void testPowerGoodInterruptDriven()
+{
+	Device device;
+	device.set<Device::ENABLE::ACTIVE>(1);
+	device.advance(30000);
+	Interrupts interrupts(device);
+	PowerGood watchdog(device);
+	interrupts.subscribe(Interrupts::VB_UV | Interrupts::VDDH_UV | Interrupts::VN_UV | Interrupts::VPOS_UV
+		| Interrupts::VEE_UV | Interrupts::VNEG_UV, PowerGood::onUV, &watchdog);
+	watchdog.start(device.now());
+	watchdog.arm(true);
+	CHECK(watchdog.isInterruptDriven());
+	for (int i = 0; i < 10000; i++)
+	{
+		device.advance(1000);
+		watchdog.tick(device.now());
+	}
+	CHECK(watchdog.polls() <= 12);
+	
+	device.injectInterrupt(0, Device::INT2::VPOS_UV::mask);
+	CHECK(device.interruptPending());
+	interrupts.onInterrupt();
+	device.advance(1000);
+	watchdog.tick(device.now());
+	CHECK(watchdog.faults() == 1);
+	CHECK(watchdog.state() == 0);
+}
+
+
+
+/*****************************************************************************************************\
+ *                                                                                                   *
+ *                                             RECOVERY                                              *
+ *                                                                                                   *
+\*****************************************************************************************************/
+
+static int recovered = -1;
+
+static void onRecovery(void *context, TPS65185_Recovery<Device>::Fault fault,
+	TPS65185_Recovery<Device>::Result result)
+{
+	(void)context;
+	(void)fault;
+	recovered = result;
+}
+
+/* A rail undervoltage is recovered with the captured configuration restored */
+static void testRecoveryRestoresConfiguration()
+{
+	typedef TPS65185_Recovery<Device> Recovery;
+	Device device;
+	device.setUPSEQ1(0x00);
+	device.set<Device::ENABLE::ACTIVE>(1);
+	device.advance(30000);
+	Recovery recovery(device);
+	recovery.capture();
+	recovery.setCallback(onRecovery);
+	recovered = -1;
+	
+	device.injectInterrupt(0, Device::INT2::VPOS_UV::mask);
+	CHECK(!device.powerGood());
+	Recovery::onFault(&recovery, device.getInterrupts().value);
+	recovery.tick(device.now());
+	CHECK(recovery.getState() == Recovery::WAITING);
+	device.write(Device::UPSEQ1::__address, uint8_t(0xff));
+	for (int i = 0; i < 1000 && recovered < 0; i++)
+	{
+		device.advance(1000);
+		recovery.tick(device.now());
+	}
+	CHECK(recovered == Recovery::RECOVERED);
+	CHECK(device.powerGood());
+	CHECK(device.getUPSEQ1() == 0x00);
+	CHECK(recovery.getMetrics().faults[Recovery::UNDERVOLTAGE] == 1);
+	CHECK(recovery.getMetrics().recoveries == 1);
+}
+
+/* Faults are classified from the INT1/INT2 bits, the most severe winning */
+static void testRecoveryClassify()
+{
+	typedef TPS65185_Recovery<Device> Recovery;
+	CHECK(Recovery::classify(uint16_t(Device::INT2::VB_UV::mask) << 8) == Recovery::UNDERVOLTAGE);
+	CHECK(Recovery::classify(uint16_t(Device::INT2::VNEG_UV::mask) << 8) == Recovery::UNDERVOLTAGE);
+	CHECK(Recovery::classify(uint16_t(Device::INT2::EOC::mask) << 8) == Recovery::NONE);
+	CHECK(Recovery::classify(uint16_t(Device::INT2::VCOMF::mask) << 8) == Recovery::VCOM_FAULT);
+	CHECK(Recovery::classify(Device::INT1::HOT::mask | Device::INT1::TSD::mask) == Recovery::THERMAL_SHUTDOWN);
+	CHECK(Recovery::classify(Device::INT1::HOT::mask) == Recovery::HOT);
+	CHECK(!(Recovery::__shutdown & (uint16_t(Device::INT2::EOC::mask) << 8)));
+}
+
+
+
+/*****************************************************************************************************\
+ *                                                                                                   *
+ *                                              PROFILE                                              *
+ *                                                                                                   *
+\*****************************************************************************************************/
+
+/* Image round trip; a damaged image is rejected */
+static void testProfileImage()
+{
+	Device device;
+	device.setUPSEQ0(0x1b);
+	device.setTMST2(0x12);
+	TPS65185_Profile profile;
+	profile.capture(device);
+	CHECK(profile.get(Device::UPSEQ0::__address) == 0x1b);
+	CHECK(profile.get(Device::INT1::__address) == 0);
+	
+	uint8_t blob[TPS65185_Profile::__size];
+	profile.encode(blob);
+	TPS65185_Profile copy;
+	CHECK(copy.decode(blob));
+	CHECK(copy.differences(profile) == 0);
+	blob[4] ^= 1;
+	CHECK(!copy.decode(blob));
+}
+
+/* apply() takes two bursts; applyChanges() writes only what differs */
+static void testProfileApply()
+{
+	Device source;
+	source.setUPSEQ1(0x00);
+	source.setDWNSEQ0(0x1b);
+	TPS65185_Profile profile;
+	profile.capture(source);
+	
+	Device device;
+	uint32_t transactions = device.busTransactions();
+	profile.apply(device);
+	CHECK(device.busTransactions() == transactions + 2);
+	CHECK(device.getUPSEQ1() == 0x00);
+	CHECK(device.getDWNSEQ0() == 0x1b);
+	
+	device.setTMST2(0x34);
+	CHECK(profile.applyChanges(device) == 1);
+	CHECK(device.getTMST2() == source.getTMST2());
+}
+
+
+int main()
+{
+	testSimPowerUpTiming();
+	testSimPowerDownTiming();
+	testSimVCOMEnableKeepsRails();
+	testSimSelfClearingBits();
+	testSimInterruptClearOnRead();
+	testSimProgramToStandby();
+	
+	testSnapshotOneBurst();
+	testStaticTransport();
+	testUserClassName();
+	
+	testCacheServesConfiguration();
+	testCacheAcquisitionDropsVCOM();
+	testCacheIgnoresReadOnlyWrite();
+	testCacheFieldsReadLive();
+	
+	testSequencerPowerUpDown();
+	testSequencerEdge();
+	
+	testTimingTimelines();
+	testSequencerWaitsForPrediction();
+	
+	testOptimizerSolve();
+	
+	testInterruptsDispatch();
+	testInterruptsUnsubscribeInHandler();
+	testInterruptsSingleTransfer();
+	
+	testTemperatureCachedReading();
+	testTemperatureDTX();
+	
+	testWaveformBands();
+	testWaveformRejectsBadBoundaries();
+	
+	testCalibrationBatch();
+	testCalibrationTimeout();
+	
+	testProgrammerPersistsSetVCOM();
+	testProgrammerSkipsAndRateLimits();
+	testProgrammerTimeout();
+	testProgrammerRestoresConfiguration();
+	
+	testUnitsConversions();
+	
+	testFleetPowersUpInWaves();
+	testFleetConfigureBatches();
+	
+	testBatchCommit();
+	testBatchRejectsBadAddress();
+	
+	testI2CDevSyscalls();
+	testI2CDevOwnership();
+	testI2CDevFailedReadNotCached();
+	
+	testTraceRecords();
+	
+	testSharedThreads();
+	testSharedFieldsAndImage();
+	
+	testPowerGoodAdaptivePolling();
+	testPowerGoodInterruptDriven();
+	
+	testRecoveryRestoresConfiguration();
+	testRecoveryClassify();
+	
+	testProfileImage();
+	testProfileApply();
+	
+	if (failures)
+	{
+		printf("%d checks failed\n", failures);
+		return 1;
+	}
+	puts("all tests passed");
+	return 0;
+}